@@ -0,0 +1,1116 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sources/MagicalContainer.hpp"
+#include "sources/Primality.hpp"
+#include "sources/PrimeSieve.hpp"
+#include "sources/BlockedSortedStorage.hpp"
+#include "sources/ConcurrentMagicalContainer.hpp"
+#include "sources/ShardedMagicalContainer.hpp"
+#include "sources/IngestingMagicalContainer.hpp"
+#include "sources/RadixSort.hpp"
+#include "sources/SortingNetwork.hpp"
+
+using namespace ariel;
+using namespace std;
+
+namespace
+{
+    template <typename Func>
+    double timeMs(Func &&func)
+    {
+        auto start = chrono::steady_clock::now();
+        func();
+        auto stop = chrono::steady_clock::now();
+        return chrono::duration<double, milli>(stop - start).count();
+    }
+
+    vector<int> randomValues(size_t count, int low, int high, unsigned seed = 42)
+    {
+        mt19937 gen(seed);
+        uniform_int_distribution<int> dist(low, high);
+        vector<int> values(count);
+        for (auto &value : values)
+        {
+            value = dist(gen);
+        }
+        return values;
+    }
+
+    void benchBulkInsert()
+    {
+        cout << "## addElement loop vs addElements\n";
+        for (size_t count : {10000UL, 100000UL, 400000UL})
+        {
+            vector<int> values = randomValues(count, 0, 1 << 30);
+            double loopMs = timeMs([&]
+                                   {
+                                       MagicalContainer container;
+                                       for (int value : values)
+                                       {
+                                           container.addElement(value);
+                                       } });
+            double bulkMs = timeMs([&]
+                                   {
+                                       MagicalContainer container;
+                                       container.addElements(values.begin(), values.end()); });
+            cout << count << " values: loop " << loopMs << " ms, bulk " << bulkMs << " ms\n";
+        }
+    }
+
+    double primeTraversalRate(MagicalContainer &container, long long &sum)
+    {
+        size_t visited = 0;
+        const int rounds = 20;
+        double elapsed = timeMs([&]
+                                {
+                                    for (int round = 0; round < rounds; ++round)
+                                    {
+                                        MagicalContainer::PrimeIterator primeIter(container);
+                                        for (auto it = primeIter.begin(); it != primeIter.end(); ++it)
+                                        {
+                                            sum += *it;
+                                            ++visited;
+                                        }
+                                    } });
+        return static_cast<double>(visited) / elapsed / 1000.0;
+    }
+
+    void benchPrimeTraversal()
+    {
+        cout << "## PrimeIterator traversal\n";
+        vector<int> values = randomValues(300000, 0, 1 << 30);
+        long long sum = 0;
+
+        MagicalContainer bulk;
+        bulk.addElements(values.begin(), values.end());
+        cout << bulk.getPrime().size() << " primes of " << bulk.size() << " elements, "
+             << sizeof(bulk.getPrime()[0]) << " bytes of index per prime\n";
+        cout << "bulk built: " << primeTraversalRate(bulk, sum) << " Mprimes/s\n";
+
+        MagicalContainer incremental;
+        for (int value : values)
+        {
+            incremental.addElement(value);
+        }
+        cout << "incrementally built: " << primeTraversalRate(incremental, sum) << " Mprimes/s (checksum " << sum << ")\n";
+    }
+
+    // The trial division isPrime the container used before the Miller-Rabin engine
+    bool trialDivisionIsPrime(int number)
+    {
+        if (number < 2)
+        {
+            return false;
+        }
+        for (int i = 2; i <= std::sqrt(number); ++i)
+        {
+            if (number % i == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void benchIsPrime()
+    {
+        cout << "## isPrime: trial division vs isPrime32\n";
+        struct Band
+        {
+            const char *name;
+            int low;
+            int high;
+        };
+        for (Band band : {Band{"small", 2, 1000}, Band{"medium", 1000000, 10000000}, Band{"near INT_MAX", 2147000000, 2147483647}})
+        {
+            vector<int> values = randomValues(100000, band.low, band.high);
+            size_t oldCount = 0;
+            size_t newCount = 0;
+            double oldMs = timeMs([&]
+                                  {
+                                      for (int value : values)
+                                      {
+                                          oldCount += trialDivisionIsPrime(value) ? 1U : 0U;
+                                      } });
+            double newMs = timeMs([&]
+                                  {
+                                      for (int value : values)
+                                      {
+                                          newCount += isPrime32(static_cast<uint32_t>(value)) ? 1U : 0U;
+                                      } });
+            cout << band.name << ": trial division " << (oldMs * 1e6 / static_cast<double>(values.size())) << " ns/call, isPrime32 "
+                 << (newMs * 1e6 / static_cast<double>(values.size())) << " ns/call (" << oldCount << " == " << newCount << " primes)\n";
+        }
+    }
+
+    void benchIsPrimeBatch()
+    {
+        cout << "## isPrime loop vs isPrimeBatch\n";
+        for (size_t batchSize : {16UL, 256UL, 4096UL, 65536UL})
+        {
+            vector<int> values = randomValues(batchSize, 0, 2147483647);
+            vector<uint8_t> out(batchSize);
+            size_t rounds = (1UL << 20U) / batchSize;
+            size_t loopCount = 0;
+            double loopMs = timeMs([&]
+                                   {
+                                       for (size_t round = 0; round < rounds; ++round)
+                                       {
+                                           for (int value : values)
+                                           {
+                                               loopCount += MagicalContainer::isPrime(value) ? 1U : 0U;
+                                           }
+                                       } });
+            double batchMs = timeMs([&]
+                                    {
+                                        for (size_t round = 0; round < rounds; ++round)
+                                        {
+                                            isPrimeBatch(values, out);
+                                        } });
+            double calls = static_cast<double>(rounds * batchSize);
+            cout << "batch " << batchSize << ": loop " << (loopMs * 1e6 / calls) << " ns/value, batch "
+                 << (batchMs * 1e6 / calls) << " ns/value (" << loopCount << " primes)\n";
+        }
+    }
+
+    void benchSieveCache()
+    {
+        cout << "## isPrime32 vs PrimeSieveCache on clustered values\n";
+        // Four dense bands of ids, one million values wide each
+        vector<uint32_t> values;
+        for (int band = 0; band < 4; ++band)
+        {
+            int low = 400000000 * (band + 1);
+            for (int value : randomValues(500000, low, low + 1000000, static_cast<unsigned>(band)))
+            {
+                values.push_back(static_cast<uint32_t>(value));
+            }
+        }
+        shuffle(values.begin(), values.end(), mt19937(1));
+
+        size_t directCount = 0;
+        double directMs = timeMs([&]
+                                 {
+                                     for (uint32_t value : values)
+                                     {
+                                         directCount += isPrime32(value) ? 1U : 0U;
+                                     } });
+        PrimeSieveCache cache;
+        size_t cachedCount = 0;
+        double cachedMs = timeMs([&]
+                                 {
+                                     for (uint32_t value : values)
+                                     {
+                                         cachedCount += cache.isPrime(value) ? 1U : 0U;
+                                     } });
+        auto perCall = [&values](double millis)
+        { return millis * 1e6 / static_cast<double>(values.size()); };
+        cout << values.size() << " lookups: isPrime32 " << perCall(directMs) << " ns/call, sieve cache " << perCall(cachedMs)
+             << " ns/call, hit rate " << cache.hitRate() * 100 << "%, " << cache.segmentCount() << " segments ("
+             << cache.memoryUsed() / 1024 << " KiB), " << directCount << " == " << cachedCount << " primes\n";
+    }
+
+    void benchAddRange()
+    {
+        cout << "## addRange vs addElement loop over a 1e6-wide interval\n";
+        const int low = 1000000000;
+        const int high = low + 999999;
+        MagicalContainer looped;
+        double loopMs = timeMs([&]
+                               {
+                                   for (int value = low; value <= high; ++value)
+                                   {
+                                       looped.addElement(value);
+                                   } });
+        MagicalContainer ranged;
+        double rangeMs = timeMs([&]
+                                { ranged.addRange(low, high); });
+        cout << "loop " << loopMs << " ms, addRange " << rangeMs << " ms (" << looped.getPrime().size() << " == "
+             << ranged.getPrime().size() << " primes)\n";
+
+        // The same interval interleaved with existing elements
+        MagicalContainer seeded;
+        vector<int> seeds = randomValues(200000, low - 500000, high + 500000);
+        seeded.addElements(seeds.begin(), seeds.end());
+        double seededMs = timeMs([&]
+                                 { seeded.addRange(low, high); });
+        cout << "addRange into 200k existing elements " << seededMs << " ms\n";
+    }
+
+    template <typename Iter, typename Container>
+    double nsPerElement(Container &container, long long &sum)
+    {
+        Iter iter(container);
+        size_t visited = 0;
+        double elapsed = timeMs([&]
+                                {
+                                    for (int round = 0; round < 10; ++round)
+                                    {
+                                        for (auto it = iter.begin(); it != iter.end(); ++it)
+                                        {
+                                            sum += *it;
+                                            ++visited;
+                                        }
+                                    } });
+        return elapsed * 1e6 / static_cast<double>(visited);
+    }
+
+    template <typename Container>
+    void iterationRow(const char *label, long long &sum)
+    {
+        Container container;
+        container.addRange(0, 1000000);
+        cout << label << ": ascending " << nsPerElement<typename Container::AscendingIterator>(container, sum) << " ns, side-cross "
+             << nsPerElement<typename Container::SideCrossIterator>(container, sum) << " ns, prime "
+             << nsPerElement<typename Container::PrimeIterator>(container, sum) << " ns; unchecked ascending "
+             << nsPerElement<typename Container::UncheckedAscendingIterator>(container, sum) << " ns, side-cross "
+             << nsPerElement<typename Container::UncheckedSideCrossIterator>(container, sum) << " ns, prime "
+             << nsPerElement<typename Container::UncheckedPrimeIterator>(container, sum) << " ns\n";
+    }
+
+    void benchIteration()
+    {
+        cout << "## Per-element iteration cost\n";
+        long long sum = 0;
+        iterationRow<MagicalContainer>("vector storage", sum);
+        iterationRow<BasicMagicalContainer<int, BlockedStorage<>>>("blocked storage", sum);
+        cout << "(checksum " << sum << ")\n";
+    }
+
+    // Half inserts, a quarter erases and a quarter rank lookups on random keys
+    template <typename Insert, typename Erase, typename Lookup>
+    double mixedWorkload(const vector<int> &keys, Insert insert, Erase erase, Lookup lookup, size_t &checksum)
+    {
+        double elapsed = timeMs([&]
+                                {
+                                    for (size_t i = 0; i < keys.size(); ++i)
+                                    {
+                                        switch (i % 4)
+                                        {
+                                        case 0:
+                                        case 2:
+                                            insert(keys[i]);
+                                            break;
+                                        case 1:
+                                            erase(keys[i - 1]);
+                                            break;
+                                        default:
+                                            checksum += lookup(keys[i]);
+                                        }
+                                    } });
+        return elapsed * 1e6 / static_cast<double>(keys.size());
+    }
+
+    void benchBlockedStorage(size_t maxSize)
+    {
+        cout << "## Flat sorted vector vs BlockedSortedStorage, mixed read/write\n";
+        for (size_t count = 10000; count <= maxSize; count *= 10)
+        {
+            vector<int> initial = randomValues(count, 0, 2147483647);
+            sort(initial.begin(), initial.end());
+            initial.erase(unique(initial.begin(), initial.end()), initial.end());
+            size_t operations = std::max<size_t>(400, 40000000 / count);
+            vector<int> keys = randomValues(operations, 0, 2147483647, 7);
+
+            size_t flatRanks = 0;
+            size_t blockedRanks = 0;
+            vector<int> flat = initial;
+            double flatNs = mixedWorkload(
+                keys, [&flat](int key)
+                {
+                    auto pos = lower_bound(flat.begin(), flat.end(), key);
+                    if (pos == flat.end() || *pos != key)
+                    {
+                        flat.insert(pos, key);
+                    } },
+                [&flat](int key)
+                {
+                    auto pos = lower_bound(flat.begin(), flat.end(), key);
+                    if (pos != flat.end() && *pos == key)
+                    {
+                        flat.erase(pos);
+                    } },
+                [&flat](int key)
+                { return static_cast<size_t>(lower_bound(flat.begin(), flat.end(), key) - flat.begin()); },
+                flatRanks);
+
+            BlockedSortedStorage<int> blocked;
+            blocked.assign(initial);
+            double blockedNs = mixedWorkload(
+                keys, [&blocked](int key)
+                { blocked.insert(key); },
+                [&blocked](int key)
+                { blocked.erase(key); },
+                [&blocked](int key)
+                { return blocked.lowerBound(key); },
+                blockedRanks);
+
+            long long sum = 0;
+            double flatScan = timeMs([&]
+                                     {
+                                         for (int value : flat)
+                                         {
+                                             sum += value;
+                                         } });
+            double blockedScan = timeMs([&]
+                                        {
+                                            for (int value : blocked)
+                                            {
+                                                sum += value;
+                                            } });
+            cout << count << " elements: flat " << flatNs << " ns/op, blocked " << blockedNs << " ns/op; full scan flat "
+                 << flatScan << " ms, blocked " << blockedScan << " ms (ranks " << flatRanks << " == " << blockedRanks << ", checksum "
+                 << sum % 1000 << ")\n";
+        }
+    }
+
+    // The same workload through MagicalContainer, where every write also
+    // keeps the prime tags current and lookups go through the prime order
+    template <typename Container>
+    double containerWorkload(const vector<int> &initial, const vector<int> &keys, size_t &checksum)
+    {
+        Container container;
+        container.build(initial);
+        return mixedWorkload(
+            keys, [&container](int key)
+            { container.addElement(key); },
+            [&container](int key)
+            { container.tryRemove(key); },
+            [&container](int key)
+            { return container.primes().lowerBound(key).position(); },
+            checksum);
+    }
+
+    void benchBlockedContainer(size_t maxSize)
+    {
+        cout << "## MagicalContainer over VectorStorage vs BlockedStorage, mixed read/write\n";
+        for (size_t count = 10000; count <= maxSize; count *= 10)
+        {
+            vector<int> initial = randomValues(count, 0, 2147483647);
+            size_t operations = std::max<size_t>(400, 40000000 / count);
+            vector<int> keys = randomValues(operations, 0, 2147483647, 7);
+
+            size_t flatRanks = 0;
+            size_t blockedRanks = 0;
+            double flatNs = containerWorkload<MagicalContainer>(initial, keys, flatRanks);
+            double blockedNs = containerWorkload<BasicMagicalContainer<int, BlockedStorage<>>>(initial, keys, blockedRanks);
+            cout << count << " elements: vector " << flatNs << " ns/op, blocked " << blockedNs << " ns/op (prime ranks "
+                 << flatRanks << " == " << blockedRanks << ")\n";
+        }
+    }
+
+    void benchRemoval()
+    {
+        cout << "## Deleting 10% of a 1e7-element container\n";
+        const int count = 10000000;
+        vector<int> victims = randomValues(count / 10, 0, count - 1, 5);
+
+        MagicalContainer bulk;
+        bulk.addRange(0, count - 1);
+        size_t removed = 0;
+        double bulkMs = timeMs([&]
+                               { removed = bulk.removeElements(victims); });
+
+        // One by one is too slow for the whole batch, so time a sample
+        MagicalContainer single;
+        single.addRange(0, count - 1);
+        const size_t sample = 200;
+        double sampleMs = timeMs([&]
+                                 {
+                                     for (size_t i = 0; i < sample; ++i)
+                                     {
+                                         try
+                                         {
+                                             single.removeElement(victims[i]);
+                                         }
+                                         catch (const runtime_error &)
+                                         {
+                                         }
+                                     } });
+        double perElement = sampleMs / static_cast<double>(sample);
+        cout << "removeElements " << bulkMs << " ms for " << removed << " elements; removeElement " << perElement * 1000
+             << " us each, about " << perElement * static_cast<double>(victims.size()) << " ms for the whole batch\n";
+    }
+
+    void benchMissHeavyRemoval()
+    {
+        cout << "## Miss-heavy removal: removeElement + catch vs tryRemove\n";
+        // Only even values are stored, so 99 in 100 probes are odd and miss
+        vector<int> probes = randomValues(200000, 0, 2000000, 9);
+        for (size_t i = 0; i < probes.size(); ++i)
+        {
+            probes[i] = (i % 100 == 0) ? probes[i] * 2 : probes[i] * 2 + 1;
+        }
+        auto fill = [](MagicalContainer &container)
+        {
+            vector<int> evens;
+            for (int value = 0; value <= 4000000; value += 2)
+            {
+                evens.push_back(value);
+            }
+            container.addElements(evens.begin(), evens.end());
+        };
+
+        MagicalContainer throwing;
+        fill(throwing);
+        size_t misses = 0;
+        double throwingMs = timeMs([&]
+                                   {
+                                       for (int probe : probes)
+                                       {
+                                           try
+                                           {
+                                               throwing.removeElement(probe);
+                                           }
+                                           catch (const runtime_error &)
+                                           {
+                                               ++misses;
+                                           }
+                                       } });
+        MagicalContainer quiet;
+        fill(quiet);
+        size_t quietMisses = 0;
+        double quietMs = timeMs([&]
+                                {
+                                    for (int probe : probes)
+                                    {
+                                        quietMisses += quiet.tryRemove(probe) ? 0U : 1U;
+                                    } });
+        cout << probes.size() << " removals, " << misses << " == " << quietMisses << " misses: removeElement " << throwingMs
+             << " ms, tryRemove " << quietMs << " ms\n";
+    }
+
+    void benchIsPrime64()
+    {
+        cout << "## isPrime64: trial division vs Montgomery Miller-Rabin\n";
+        std::mt19937_64 rng(42);
+        for (unsigned bits : {40U, 52U, 63U})
+        {
+            vector<uint64_t> values(100000);
+            for (uint64_t &value : values)
+            {
+                value = (rng() >> (64U - bits)) | 1U;
+            }
+            size_t primeCount = 0;
+            double fastMs = timeMs([&]
+                                   {
+                                       for (uint64_t value : values)
+                                       {
+                                           primeCount += isPrime64(value) ? 1U : 0U;
+                                       } });
+            // Trial division is timed on a small sample; a 63-bit prime alone takes seconds
+            size_t sample = bits <= 40 ? 2000 : 20;
+            size_t trialCount = 0;
+            double trialMs = timeMs([&]
+                                    {
+                                        for (size_t idx = 0; idx < sample; ++idx)
+                                        {
+                                            trialCount += isPrimeTrialDivision(values[idx]) ? 1U : 0U;
+                                        } });
+            cout << bits << "-bit: isPrime64 " << (fastMs * 1e6 / static_cast<double>(values.size())) << " ns/call (" << primeCount
+                 << " primes), trial division " << (trialMs * 1e6 / static_cast<double>(sample)) << " ns/call (" << trialCount
+                 << " primes in " << sample << ")\n";
+        }
+
+        MagicalContainer64 container;
+        vector<int64_t> ids(1000000);
+        for (int64_t &id : ids)
+        {
+            id = static_cast<int64_t>(rng() >> 1U);
+        }
+        double bulkMs = timeMs([&]
+                               { container.addElements(std::span<const int64_t>(ids)); });
+        cout << "MagicalContainer64 addElements of 1e6 random 63-bit ids: " << bulkMs << " ms, " << container.primes().size() << " primes\n";
+    }
+
+    struct MixedResult
+    {
+        double walksPerSec;
+        double writesPerSec;
+    };
+
+    // readerCount threads walk the whole container in a loop while one writer
+    // streams addElement calls; walk(sum) runs one full ascending walk
+    template <typename Walk, typename Write>
+    MixedResult runReadersAndWriter(unsigned readerCount, Walk walk, Write write)
+    {
+        constexpr auto DURATION = std::chrono::milliseconds(300);
+        std::atomic<bool> stop{false};
+        std::atomic<size_t> walks{0};
+        std::atomic<size_t> checksum{0};
+        vector<std::thread> readers;
+        for (unsigned reader = 0; reader < readerCount; ++reader)
+        {
+            readers.emplace_back([&]
+                                 {
+                                     size_t mine = 0;
+                                     size_t sum = 0;
+                                     while (!stop.load(std::memory_order_relaxed))
+                                     {
+                                         walk(sum);
+                                         ++mine;
+                                     }
+                                     walks += mine;
+                                     checksum += sum; });
+        }
+        size_t writes = 0;
+        auto start = std::chrono::steady_clock::now();
+        int value = 1 << 28;
+        while (std::chrono::steady_clock::now() - start < DURATION)
+        {
+            write(value++);
+            ++writes;
+        }
+        stop = true;
+        for (std::thread &reader : readers)
+        {
+            reader.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return {static_cast<double>(walks.load()) / seconds, static_cast<double>(writes) / seconds};
+    }
+
+    void benchConcurrentReaders()
+    {
+        cout << "## Readers walking 1e5 elements while one writer streams addElement\n";
+        cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+        vector<int> initial = randomValues(100000, 0, 1 << 27);
+        for (unsigned readers : {1U, 2U, 4U, 8U})
+        {
+            MagicalContainer locked;
+            locked.addElements(initial);
+            std::mutex global;
+            MixedResult mutexed = runReadersAndWriter(
+                readers, [&](size_t &sum)
+                {
+                    std::lock_guard<std::mutex> guard(global);
+                    for (int value : locked.ascending())
+                    {
+                        sum += static_cast<size_t>(value);
+                    } },
+                [&](int value)
+                {
+                    std::lock_guard<std::mutex> guard(global);
+                    locked.addElement(value); });
+
+            cout << readers << " readers: global mutex " << mutexed.walksPerSec << " walks/s, " << mutexed.writesPerSec << " writes/s";
+            for (size_t interval : {1UL, 256UL})
+            {
+                ConcurrentMagicalContainer concurrent;
+                concurrent.addElements(initial);
+                concurrent.setPublishInterval(interval);
+                MixedResult snapshotted = runReadersAndWriter(
+                    readers, [&](size_t &sum)
+                    {
+                        auto snapshot = concurrent.snapshot();
+                        for (int value : snapshot->ascending())
+                        {
+                            sum += static_cast<size_t>(value);
+                        } },
+                    [&](int value)
+                    { concurrent.addElement(value); });
+                cout << "; snapshots/" << interval << " " << snapshotted.walksPerSec << " walks/s, " << snapshotted.writesPerSec << " writes/s";
+            }
+            cout << "\n";
+        }
+    }
+
+    void benchConcurrentLookups()
+    {
+        cout << "## Readers calling contains() while one writer streams addElement\n";
+        vector<int> initial = randomValues(100000, 0, 1 << 27);
+        vector<int> probes = randomValues(1000, 0, 1 << 27, 3);
+        for (unsigned readers : {1U, 2U, 4U, 8U})
+        {
+            MagicalContainer locked;
+            locked.addElements(initial);
+            std::mutex global;
+            MixedResult mutexed = runReadersAndWriter(
+                readers, [&](size_t &hits)
+                {
+                    for (int probe : probes)
+                    {
+                        std::lock_guard<std::mutex> guard(global);
+                        hits += locked.contains(probe) ? 1U : 0U;
+                    } },
+                [&](int value)
+                {
+                    std::lock_guard<std::mutex> guard(global);
+                    locked.addElement(value); });
+
+            ConcurrentMagicalContainer concurrent;
+            concurrent.addElements(initial);
+            MixedResult published = runReadersAndWriter(
+                readers, [&](size_t &hits)
+                {
+                    for (int probe : probes)
+                    {
+                        hits += concurrent.contains(probe) ? 1U : 0U;
+                    } },
+                [&](int value)
+                { concurrent.addElement(value); });
+            cout << readers << " readers: global mutex " << mutexed.walksPerSec * static_cast<double>(probes.size()) << " lookups/s, "
+                 << mutexed.writesPerSec << " writes/s; concurrent " << published.walksPerSec * static_cast<double>(probes.size())
+                 << " lookups/s, " << published.writesPerSec << " writes/s\n";
+        }
+    }
+
+    // Splits values across threadCount writers that each call add(value)
+    template <typename Add>
+    double timeWriters(unsigned threadCount, const vector<int> &values, Add add)
+    {
+        return timeMs([&]
+                      {
+                          vector<std::thread> writers;
+                          for (unsigned writer = 0; writer < threadCount; ++writer)
+                          {
+                              writers.emplace_back([&, writer]
+                                                   {
+                                                       for (size_t idx = writer; idx < values.size(); idx += threadCount)
+                                                       {
+                                                           add(values[idx]);
+                                                       } });
+                          }
+                          for (std::thread &writer : writers)
+                          {
+                              writer.join();
+                          } });
+    }
+
+    void benchShardedWriters()
+    {
+        cout << "## addElement from 1..32 threads: one locked container vs 64 range shards\n";
+        cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+        vector<int> values = randomValues(200000, 0, 1 << 30);
+        for (unsigned threads : {1U, 2U, 4U, 8U, 16U, 32U})
+        {
+            BasicMagicalContainer<int, VectorStorage, MillerRabinPrimality, SharedMutexLock> single;
+            double singleMs = timeWriters(threads, values, [&](int value)
+                                          { single.addElement(value); });
+            ShardedMagicalContainer sharded(64, 0, 1 << 30);
+            double shardedMs = timeWriters(threads, values, [&](int value)
+                                           { sharded.addElement(value); });
+            cout << threads << " threads: single " << (static_cast<double>(values.size()) / singleMs * 1e3) << " adds/s, sharded "
+                 << (static_cast<double>(values.size()) / shardedMs * 1e3) << " adds/s (" << single.size() << " == " << sharded.size() << ")\n";
+        }
+    }
+
+    void benchIngest()
+    {
+        cout << "## Producers calling addElement: global mutex vs lock-free ingest queue\n";
+        cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+        constexpr size_t TOTAL = 400000;
+        // Value idx is the id of the idx-th add, so latency can be matched per value
+        vector<int> ids(TOTAL);
+        for (size_t idx = 0; idx < TOTAL; ++idx)
+        {
+            ids[idx] = static_cast<int>(idx);
+        }
+        std::shuffle(ids.begin(), ids.end(), std::mt19937(42));
+
+        for (unsigned producers : {1U, 4U, 16U})
+        {
+            MagicalContainer locked;
+            std::mutex global;
+            double mutexMs = timeWriters(producers, ids, [&](int value)
+                                         {
+                                             std::lock_guard<std::mutex> guard(global);
+                                             locked.addElement(value); });
+
+            using Clock = std::chrono::steady_clock;
+            vector<Clock::time_point> pushedAt(TOTAL);
+            vector<Clock::time_point> mergedAt(TOTAL);
+            double ingestMs = 0;
+            {
+                IngestingMagicalContainer ingest([&mergedAt](std::span<const int> batch)
+                                                 {
+                                                     auto now = Clock::now();
+                                                     for (int value : batch)
+                                                     {
+                                                         mergedAt[static_cast<size_t>(value)] = now;
+                                                     } });
+                ingestMs = timeWriters(producers, ids, [&](int value)
+                                       {
+                                           pushedAt[static_cast<size_t>(value)] = Clock::now();
+                                           ingest.addElement(value); });
+                double flushMs = timeMs([&]
+                                        { ingest.flush(); });
+                cout << producers << " producers: mutex+addElement " << (static_cast<double>(TOTAL) / mutexMs * 1e3) << " adds/s; ingest push "
+                     << (static_cast<double>(TOTAL) / ingestMs * 1e3) << " adds/s, final flush " << flushMs << " ms, "
+                     << ingest.mergedBatches() << " batches (" << locked.size() << " == " << ingest.size() << ")\n";
+            }
+
+            vector<double> latencyUs(TOTAL);
+            for (size_t idx = 0; idx < TOTAL; ++idx)
+            {
+                latencyUs[idx] = std::chrono::duration<double, std::micro>(mergedAt[idx] - pushedAt[idx]).count();
+            }
+            std::sort(latencyUs.begin(), latencyUs.end());
+            cout << "    add-to-merged latency us: p50 " << latencyUs[TOTAL / 2] << ", p90 " << latencyUs[TOTAL * 9 / 10] << ", p99 "
+                 << latencyUs[TOTAL * 99 / 100] << ", p99.9 " << latencyUs[TOTAL * 999 / 1000] << ", max " << latencyUs.back() << "\n";
+        }
+    }
+
+    void benchParallelBuild(size_t count)
+    {
+        cout << "## build() of " << count << " random values in [0, 2^31) vs addElements\n";
+        cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+        vector<int> values = randomValues(count, 0, 2147483647);
+        MagicalContainer bulk;
+        double bulkMs = timeMs([&]
+                               { bulk.addElements(values); });
+        cout << "addElements: " << bulkMs << " ms\n";
+        for (unsigned threads : {1U, 2U, 4U, 8U})
+        {
+            MagicalContainer built;
+            double buildMs = timeMs([&]
+                                    { built.build(values, threads); });
+            cout << threads << " threads: build " << buildMs << " ms, " << (bulkMs / buildMs) << "x addElements ("
+                 << (built.getPrime() == bulk.getPrime() ? "same" : "DIFFERENT") << " primes)\n";
+        }
+    }
+
+    void benchSortingNetwork()
+    {
+        cout << "## std::sort vs sorting network per micro-batch\n";
+        const size_t total = 1 << 20;
+        vector<int> values = randomValues(total, -1000000, 1000000);
+        for (size_t batchSize : {8UL, 16UL, 24UL, 32UL, 64UL, 100UL, 128UL, 256UL})
+        {
+            size_t batches = total / batchSize;
+            auto timeBatches = [&](auto sorter)
+            {
+                vector<int> work = values;
+                double ms = timeMs([&]
+                                   {
+                                       for (size_t batch = 0; batch < batches; ++batch)
+                                       {
+                                           sorter(std::span<int>(work.data() + batch * batchSize, batchSize));
+                                       } });
+                return ms * 1e6 / static_cast<double>(batches);
+            };
+            double stdNs = timeBatches([](std::span<int> batch)
+                                       { std::sort(batch.begin(), batch.end()); });
+            double scalarNs = timeBatches([](std::span<int> batch)
+                                          { sortSmallScalar(batch); });
+            double networkNs = timeBatches([](std::span<int> batch)
+                                           { sortSmall(batch); });
+
+            // End to end: the same stream fed to a container one micro-batch at a time
+            size_t fed = std::min<size_t>(total, 1 << 16);
+            double addNs = timeMs([&]
+                                  {
+                                      MagicalContainer container;
+                                      for (size_t first = 0; first + batchSize <= fed; first += batchSize)
+                                      {
+                                          container.addElements(std::span<const int>(values.data() + first, batchSize));
+                                      } }) *
+                           1e6 / static_cast<double>(fed / batchSize);
+            cout << batchSize << ": std::sort " << stdNs << " ns, scalar network " << scalarNs << " ns, sortSmall "
+                 << networkNs << " ns (" << (stdNs / networkNs) << "x); addElements " << addNs << " ns/batch\n";
+        }
+    }
+
+    void benchContainsBatch()
+    {
+        cout << "## contains loop vs containsBatch, 1M random queries, ~50% hits\n";
+        const size_t queryCount = 1000000;
+        for (size_t count : {10000UL, 100000UL, 1000000UL, 10000000UL, 20000000UL})
+        {
+            vector<int> evens(count);
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                evens[idx] = static_cast<int>(idx * 2);
+            }
+            MagicalContainer container;
+            container.build(evens);
+            vector<int> queries = randomValues(queryCount, 0, static_cast<int>(count * 2));
+
+            size_t loopHits = 0;
+            double loopMs = timeMs([&]
+                                   {
+                                       for (int query : queries)
+                                       {
+                                           loopHits += static_cast<size_t>(container.contains(query));
+                                       } });
+            std::unique_ptr<bool[]> found(new bool[queryCount]);
+            double batchMs = timeMs([&]
+                                    { container.containsBatch(queries, std::span<bool>(found.get(), queryCount)); });
+            size_t batchHits = static_cast<size_t>(std::count(found.get(), found.get() + queryCount, true));
+            cout << count << " elements (" << count * sizeof(int) / 1024 << " KiB): loop " << loopMs * 1e6 / queryCount
+                 << " ns/query, batch " << batchMs * 1e6 / queryCount << " ns/query (" << (loopMs / batchMs) << "x)"
+                 << (loopHits == batchHits ? "" : " MISMATCH") << "\n";
+        }
+    }
+
+    void benchSearchIndex()
+    {
+        cout << "## contains over VectorStorage vs IndexedStorage, 1M random queries\n";
+        const size_t queryCount = 1000000;
+        for (size_t count : {10000UL, 100000UL, 1000000UL, 10000000UL, 20000000UL})
+        {
+            vector<int> evens(count);
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                evens[idx] = static_cast<int>(idx * 2);
+            }
+            vector<int> queries = randomValues(queryCount, 0, static_cast<int>(count * 2));
+            auto timeContains = [&](auto &container)
+            {
+                size_t hits = 0;
+                double ms = timeMs([&]
+                                   {
+                                       for (int query : queries)
+                                       {
+                                           hits += static_cast<size_t>(container.contains(query));
+                                       } });
+                return std::make_pair(ms * 1e6 / queryCount, hits);
+            };
+
+            MagicalContainer plain;
+            plain.build(evens);
+            BasicMagicalContainer<int, IndexedStorage<>> indexed;
+            indexed.build(evens);
+            auto [plainNs, plainHits] = timeContains(plain);
+            // The first pass includes the lazy rebuild, the second runs on the built tree
+            auto [firstNs, firstHits] = timeContains(indexed);
+            auto [indexedNs, indexedHits] = timeContains(indexed);
+            cout << count << " elements: vector " << plainNs << " ns/query, indexed " << indexedNs << " ns/query ("
+                 << (plainNs / indexedNs) << "x), first pass incl. rebuild " << firstNs << " ns/query"
+                 << (plainHits == indexedHits && firstHits == indexedHits ? "" : " MISMATCH") << "\n";
+        }
+
+        cout << "## addElement loop, 20000 random values: stale index must not rebuild per insert\n";
+        vector<int> values = randomValues(20000, 0, 1 << 30);
+        double plainMs = timeMs([&]
+                                {
+                                    MagicalContainer container;
+                                    for (int value : values)
+                                    {
+                                        container.addElement(value);
+                                    } });
+        double indexedMs = timeMs([&]
+                                  {
+                                      BasicMagicalContainer<int, IndexedStorage<>> container;
+                                      for (int value : values)
+                                      {
+                                          container.addElement(value);
+                                      } });
+        cout << "vector " << plainMs << " ms, indexed " << indexedMs << " ms\n";
+    }
+
+    void benchSuccessor()
+    {
+        cout << "## next prime >= x: walking primes() from begin vs primes().lowerBound\n";
+        for (int high : {100000, 1000000, 10000000})
+        {
+            MagicalContainer container;
+            container.addRange(0, high);
+            vector<int> queries = randomValues(200, 0, high);
+            long long walkSum = 0;
+            double walkMs = timeMs([&]
+                                   {
+                                       for (int query : queries)
+                                       {
+                                           auto primes = container.primes();
+                                           auto it = std::ranges::find_if(primes, [query](int prime)
+                                                                          { return prime >= query; });
+                                           walkSum += it == primes.end() ? 0 : *it;
+                                       } });
+            long long searchSum = 0;
+            double searchMs = timeMs([&]
+                                     {
+                                         for (int query : queries)
+                                         {
+                                             auto it = container.primes().lowerBound(query);
+                                             searchSum += it == container.primes().end() ? 0 : *it;
+                                         } });
+            cout << "[0, " << high << "]: walk " << walkMs * 1e3 / 200 << " us/query, lowerBound "
+                 << searchMs * 1e6 / 200 << " ns/query" << (walkSum == searchSum ? "" : " MISMATCH") << "\n";
+        }
+    }
+
+    // Resumes a 100-element page at a random value: ++ from begin() vs seek
+    template <typename Iterator>
+    void benchPagination(MagicalContainer &container, const vector<int> &starts, const char *name)
+    {
+        const int pageSize = 100;
+        long long walkSum = 0;
+        double walkMs = timeMs([&]
+                               {
+                                   for (int start : starts)
+                                   {
+                                       Iterator it(container);
+                                       Iterator end(container);
+                                       end.end();
+                                       while (it != end && *it < start)
+                                       {
+                                           ++it;
+                                       }
+                                       for (int step = 0; step < pageSize && it != end; ++step, ++it)
+                                       {
+                                           walkSum += *it;
+                                       }
+                                   } });
+        long long seekSum = 0;
+        double seekMs = timeMs([&]
+                               {
+                                   for (int start : starts)
+                                   {
+                                       Iterator it(container);
+                                       Iterator end(container);
+                                       end.end();
+                                       it.seek(start);
+                                       for (int step = 0; step < pageSize && it != end; ++step, ++it)
+                                       {
+                                           seekSum += *it;
+                                       }
+                                   } });
+        cout << name << ": ++ from begin " << walkMs * 1e3 / static_cast<double>(starts.size()) << " us/page, seek "
+             << seekMs * 1e3 / static_cast<double>(starts.size()) << " us/page" << (walkSum == seekSum ? "" : " MISMATCH") << "\n";
+    }
+
+    void benchSeek()
+    {
+        cout << "## paginated scans over addRange(0, 1e7): 200 pages of 100 from random start values\n";
+        MagicalContainer container;
+        container.addRange(0, 10000000);
+        vector<int> starts = randomValues(200, 0, 10000000);
+        benchPagination<MagicalContainer::AscendingIterator>(container, starts, "AscendingIterator");
+        benchPagination<MagicalContainer::PrimeIterator>(container, starts, "PrimeIterator");
+    }
+
+    void benchRadixSort(size_t maxCount)
+    {
+        cout << "## std::sort vs radixSort on random signed ints\n";
+        cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+        for (size_t count = 256; count <= maxCount; count *= (count < 100000 ? 4 : 10))
+        {
+            vector<int> values = randomValues(count, -2147483647, 2147483647);
+            size_t rounds = std::max<size_t>(1, 4000000 / count);
+            auto timeSort = [&](auto sorter)
+            {
+                vector<int> work;
+                double total = 0;
+                for (size_t round = 0; round < rounds; ++round)
+                {
+                    work = values;
+                    total += timeMs([&]
+                                    { sorter(work); });
+                }
+                return total / static_cast<double>(rounds);
+            };
+            double stdMs = timeSort([](vector<int> &work)
+                                    { std::sort(work.begin(), work.end()); });
+            double radixMs = timeSort([](vector<int> &work)
+                                      { radixSort(std::span<int>(work), 1); });
+            double radixAllMs = timeSort([](vector<int> &work)
+                                         { radixSort(std::span<int>(work), 0); });
+            cout << count << ": std::sort " << stdMs << " ms, radixSort 1 thread " << radixMs << " ms ("
+                 << (stdMs / radixMs) << "x), all threads " << radixAllMs << " ms\n";
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *only = argc > 1 ? argv[1] : nullptr;
+    auto wanted = [only](const char *name)
+    { return only == nullptr || strcmp(only, name) == 0; };
+
+    if (wanted("bulk"))
+    {
+        benchBulkInsert();
+    }
+    if (wanted("primes"))
+    {
+        benchPrimeTraversal();
+    }
+    if (wanted("isprime"))
+    {
+        benchIsPrime();
+    }
+    if (wanted("isprimebatch"))
+    {
+        benchIsPrimeBatch();
+    }
+    if (wanted("sieve"))
+    {
+        benchSieveCache();
+    }
+    if (wanted("range"))
+    {
+        benchAddRange();
+    }
+    if (wanted("iterate"))
+    {
+        benchIteration();
+    }
+    if (wanted("blocked"))
+    {
+        benchBlockedStorage(argc > 2 ? std::stoul(argv[2]) : 10000000);
+        benchBlockedContainer(argc > 2 ? std::stoul(argv[2]) : 10000000);
+    }
+    if (wanted("remove"))
+    {
+        benchRemoval();
+    }
+    if (wanted("tryremove"))
+    {
+        benchMissHeavyRemoval();
+    }
+    if (wanted("isprime64"))
+    {
+        benchIsPrime64();
+    }
+    if (wanted("concurrent"))
+    {
+        benchConcurrentReaders();
+        benchConcurrentLookups();
+    }
+    if (wanted("sharded"))
+    {
+        benchShardedWriters();
+    }
+    if (wanted("ingest"))
+    {
+        benchIngest();
+    }
+    if (wanted("build"))
+    {
+        benchParallelBuild(argc > 2 ? std::stoul(argv[2]) : 10000000);
+    }
+    if (wanted("network"))
+    {
+        benchSortingNetwork();
+    }
+    if (wanted("search"))
+    {
+        benchContainsBatch();
+    }
+    if (wanted("index"))
+    {
+        benchSearchIndex();
+    }
+    if (wanted("successor"))
+    {
+        benchSuccessor();
+    }
+    if (wanted("seek"))
+    {
+        benchSeek();
+    }
+    if (wanted("radix"))
+    {
+        benchRadixSort(argc > 2 ? std::stoul(argv[2]) : 100000000);
+    }
+    return 0;
+}
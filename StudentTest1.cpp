@@ -1,6 +1,18 @@
 #include "doctest.h"
 #include "sources/MagicalContainer.hpp"
+#include "sources/Primality.hpp"
+#include "sources/PrimeSieve.hpp"
+#include "sources/BlockedSortedStorage.hpp"
+#include "sources/ConcurrentMagicalContainer.hpp"
+#include "sources/ShardedMagicalContainer.hpp"
+#include "sources/IngestingMagicalContainer.hpp"
+#include "sources/RadixSort.hpp"
+#include "sources/SortingNetwork.hpp"
+#include "sources/SearchTree.hpp"
+#include <set>
+#include <random>
 #include <stdexcept>
+#include <thread>
 
 using namespace ariel;
 using namespace std;
@@ -596,3 +608,1435 @@ TEST_CASE("operator= throws when iterators are pointing at different containers"
    }
 }
 
+
+TEST_CASE("Bulk addElements") {
+    MagicalContainer container;
+    container.addElement(4);
+    container.addElement(7);
+
+    SUBCASE("Merging an unsorted batch with duplicates") {
+        vector<int> batch = {9, 2, 7, 11, 2, -5, 4, 13};
+        container.addElements(batch.begin(), batch.end());
+        CHECK(container.size() == 7);
+
+        MagicalContainer::AscendingIterator ascIter(container);
+        vector<int> ascending;
+        for (auto it = ascIter.begin(); it != ascIter.end(); ++it) {
+            ascending.push_back(*it);
+        }
+        CHECK(ascending == vector<int>{-5, 2, 4, 7, 9, 11, 13});
+
+        MagicalContainer::PrimeIterator primeIter(container);
+        vector<int> primes;
+        for (auto it = primeIter.begin(); it != primeIter.end(); ++it) {
+            primes.push_back(*it);
+        }
+        CHECK(primes == vector<int>{2, 7, 11, 13});
+    }
+
+    SUBCASE("Bulk insert matches element by element insert") {
+        MagicalContainer single;
+        vector<int> batch;
+        for (int i = 0; i < 200; ++i) {
+            batch.push_back((i * 37) % 101 - 20);
+        }
+        for (int value : batch) {
+            single.addElement(value);
+        }
+        single.addElement(4);
+        single.addElement(7);
+        container.addElements(std::span<const int>(batch));
+        CHECK(container.size() == single.size());
+        CHECK(container.getVec() == single.getVec());
+        CHECK(container.getPrime().size() == single.getPrime().size());
+        // Writing through getVec() would desynchronise the prime index
+        static_assert(std::is_const_v<std::remove_reference_t<decltype(container.getVec())>>);
+    }
+}
+
+TEST_CASE("PrimeIterator after interleaved adds and removes") {
+    MagicalContainer container;
+    for (int value : {10, 3, 8, 7, 1, 13, 4}) {
+        container.addElement(value);
+    }
+    container.removeElement(8);
+    container.addElement(2);
+    container.removeElement(3);
+    container.addElement(12);
+
+    MagicalContainer::PrimeIterator primeIter(container);
+    vector<int> primes;
+    for (auto it = primeIter.begin(); it != primeIter.end(); ++it) {
+        primes.push_back(*it);
+    }
+    CHECK(primes == vector<int>{2, 7, 13});
+}
+
+TEST_CASE("isPrime agrees with trial division") {
+    auto trialDivision = [](int number) {
+        if (number < 2) {
+            return false;
+        }
+        for (int i = 2; static_cast<long long>(i) * i <= number; ++i) {
+            if (number % i == 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool allMatch = true;
+    for (int number = -10; number < 200000; ++number) {
+        allMatch = allMatch && (MagicalContainer::isPrime(number) == trialDivision(number));
+    }
+    CHECK(allMatch);
+
+    for (int number : {1681, 1763, 25326001, 2147483647, 2147483646, 2147483629, 2147483643, 2147395600, 2146654199}) {
+        CHECK(MagicalContainer::isPrime(number) == trialDivision(number));
+    }
+}
+
+TEST_CASE("isPrimeBatch agrees with isPrime") {
+    mt19937 gen(7);
+    uniform_int_distribution<int> anyInt(-1000, 2147483647);
+    vector<int> numbers;
+    for (int i = 0; i < 20000; ++i) {
+        numbers.push_back(i % 3 == 0 ? i : anyInt(gen));
+    }
+    for (int number = 2147483647; number > 2147483647 - 2000; --number) {
+        numbers.push_back(number);
+    }
+
+    vector<uint8_t> out(numbers.size());
+    isPrimeBatch(numbers, out);
+    bool allMatch = true;
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        allMatch = allMatch && ((out[i] != 0) == MagicalContainer::isPrime(numbers[i]));
+    }
+    CHECK(allMatch);
+
+    vector<uint8_t> shortOut(numbers.size() - 1);
+    CHECK_THROWS_AS(isPrimeBatch(numbers, shortOut), runtime_error);
+}
+
+TEST_CASE("PrimeSieveCache") {
+    SUBCASE("Sieved segments agree with isPrime") {
+        PrimeSieveCache cache;
+        bool allMatch = true;
+        for (uint32_t first : {0U, 8700 * PrimeSieveCache::SEGMENT_SPAN}) {
+            cache.sieveSegmentOf(first);
+            for (uint32_t number = first; number < first + PrimeSieveCache::SEGMENT_SPAN; ++number) {
+                bool verdict = false;
+                allMatch = allMatch && cache.lookup(number, verdict) && verdict == isPrime32(number);
+            }
+        }
+        CHECK(allMatch);
+    }
+
+    SUBCASE("Segments are sieved after repeated misses and counted as hits") {
+        PrimeSieveCache cache(PrimeSieveCache::DEFAULT_MEMORY_CAP, 4);
+        for (uint32_t number = 1000; number < 1004; ++number) {
+            cache.isPrime(number);
+        }
+        CHECK(cache.segmentCount() == 1);
+        CHECK(cache.misses() == 4);
+        CHECK(cache.isPrime(1009));
+        CHECK_FALSE(cache.isPrime(1011));
+        CHECK(cache.hits() == 2);
+        CHECK(cache.hitRate() == doctest::Approx(2.0 / 6.0));
+    }
+
+    SUBCASE("Least recently used segments are evicted under the memory cap") {
+        PrimeSieveCache cache(2 * PrimeSieveCache::SEGMENT_BYTES);
+        cache.sieveSegmentOf(0);
+        cache.sieveSegmentOf(PrimeSieveCache::SEGMENT_SPAN);
+        bool verdict = false;
+        CHECK(cache.lookup(5, verdict));
+        cache.sieveSegmentOf(2 * PrimeSieveCache::SEGMENT_SPAN);
+        CHECK(cache.segmentCount() == 2);
+        CHECK(cache.memoryUsed() <= cache.memoryCap());
+        CHECK(cache.lookup(5, verdict));
+        CHECK_FALSE(cache.lookup(PrimeSieveCache::SEGMENT_SPAN + 1, verdict));
+    }
+
+    SUBCASE("addElement classifies through the container's sieve") {
+        MagicalContainer container;
+        container.getSieve().setSieveAfterMisses(1);
+        for (int value = 100; value < 200; ++value) {
+            container.addElement(value);
+        }
+        CHECK(container.getSieve().hits() == 99);
+        CHECK(container.getPrime().size() == 21);
+    }
+}
+
+TEST_CASE("addRange") {
+    MagicalContainer container;
+    container.addElement(-3);
+    container.addElement(5);
+    container.addElement(40);
+
+    SUBCASE("Inserting an interval skips values already present") {
+        container.addRange(-5, 12);
+        CHECK(container.size() == 19);
+
+        MagicalContainer::PrimeIterator primeIter(container);
+        vector<int> primes;
+        for (auto it = primeIter.begin(); it != primeIter.end(); ++it) {
+            primes.push_back(*it);
+        }
+        CHECK(primes == vector<int>{2, 3, 5, 7, 11});
+        CHECK(container.getVec().back() == 40);
+    }
+
+    SUBCASE("Matches element by element insert on a large interval") {
+        MagicalContainer single;
+        single.addElement(-3);
+        single.addElement(5);
+        single.addElement(40);
+        for (int value = 999000; value <= 1001000; ++value) {
+            single.addElement(value);
+        }
+        container.addRange(999000, 1001000);
+        CHECK(container.getVec() == single.getVec());
+        CHECK(container.getPrime() == single.getPrime());
+    }
+
+    SUBCASE("Empty and extreme intervals") {
+        container.addRange(10, 9);
+        CHECK(container.size() == 3);
+        container.addRange(2147483640, 2147483647);
+        CHECK(container.size() == 11);
+        CHECK(container.getVec().back() == 2147483647);
+        CHECK(container.getPrime().size() == 2);
+    }
+}
+
+TEST_CASE("SideCrossIterator loop reaches end() for every size") {
+    for (int count = 0; count <= 7; ++count) {
+        MagicalContainer container;
+        if (count > 0) {
+            container.addRange(1, count);
+        }
+        MagicalContainer::SideCrossIterator crossIter(container);
+        vector<int> order;
+        for (auto it = crossIter.begin(); it != crossIter.end(); ++it) {
+            order.push_back(*it);
+            REQUIRE(order.size() <= static_cast<size_t>(count));
+        }
+        vector<int> expected;
+        for (int low = 1, high = count; low <= high; ++low, --high) {
+            expected.push_back(low);
+            if (low != high) {
+                expected.push_back(high);
+            }
+        }
+        CHECK(order == expected);
+    }
+}
+
+TEST_CASE("Ranges views") {
+    static_assert(std::ranges::view<MagicalContainer::AscendingView>);
+    static_assert(std::ranges::forward_range<MagicalContainer::SideCrossView>);
+    static_assert(std::ranges::sized_range<MagicalContainer::PrimeView>);
+    static_assert(std::is_trivially_copyable_v<MagicalContainer::PrimeView::iterator>);
+
+    MagicalContainer container;
+    for (int value : {1, 2, 4, 5, 14}) {
+        container.addElement(value);
+    }
+
+    SUBCASE("Range-for matches the classic iterators") {
+        vector<int> ascending;
+        for (int value : container.ascending()) {
+            ascending.push_back(value);
+        }
+        CHECK(ascending == vector<int>{1, 2, 4, 5, 14});
+
+        vector<int> cross;
+        std::ranges::copy(container.sideCross(), std::back_inserter(cross));
+        CHECK(cross == vector<int>{1, 14, 2, 5, 4});
+
+        MagicalContainer::SideCrossIterator crossIter(container);
+        vector<int> classic;
+        for (auto it = crossIter.begin(); it != crossIter.end(); ++it) {
+            classic.push_back(*it);
+        }
+        CHECK(classic == cross);
+    }
+
+    SUBCASE("Works with std::ranges algorithms and adaptors") {
+        CHECK(std::ranges::count_if(container.primes(), [](int value) { return value > 2; }) == 1);
+        CHECK(*std::ranges::find(container.ascending(), 5) == 5);
+        CHECK(std::ranges::find(container.ascending(), 3) == container.ascending().end());
+
+        vector<int> evens;
+        for (int value : container.ascending() | std::views::filter([](int value) { return value % 2 == 0; })) {
+            evens.push_back(value);
+        }
+        CHECK(evens == vector<int>{2, 4, 14});
+        CHECK(container.primes().size() == 2);
+    }
+
+    SUBCASE("Views follow the container") {
+        auto primes = container.primes();
+        container.addElement(7);
+        vector<int> seen;
+        std::ranges::copy(primes, std::back_inserter(seen));
+        CHECK(seen == vector<int>{2, 5, 7});
+        CHECK(std::ranges::distance(primes) == 3);
+    }
+}
+
+// Checks every jump of an iterator kind against plain step-by-step iteration
+template <typename Iter>
+void checkJumpsMatchSteps(MagicalContainer &container) {
+    Iter stepper(container);
+    vector<int> stepped;
+    for (auto it = stepper.begin(); it != stepper.end(); ++it) {
+        stepped.push_back(*it);
+    }
+
+    bool allMatch = true;
+    for (size_t k = 0; k <= stepped.size(); ++k) {
+        Iter jumper(container);
+        jumper.begin();
+        jumper += static_cast<ptrdiff_t>(k);
+        Iter first(container);
+        first.begin();
+        allMatch = allMatch && (jumper - first) == static_cast<ptrdiff_t>(k);
+        if (k < stepped.size()) {
+            allMatch = allMatch && *jumper == stepped[k] && first[static_cast<ptrdiff_t>(k)] == stepped[k];
+        } else {
+            Iter last(container);
+            allMatch = allMatch && jumper == last.end();
+        }
+        if (k > 0) {
+            jumper -= 1;
+            allMatch = allMatch && *jumper == stepped[k - 1];
+        }
+    }
+    CHECK(allMatch);
+
+    Iter outOfRange(container);
+    outOfRange.begin();
+    CHECK_THROWS_AS(outOfRange += static_cast<ptrdiff_t>(stepped.size() + 1), runtime_error);
+    CHECK_THROWS_AS(outOfRange -= 1, runtime_error);
+}
+
+TEST_CASE("Random access jumps match step-by-step iteration") {
+    for (int count = 0; count <= 9; ++count) {
+        MagicalContainer container;
+        for (int value = 1; value <= count; ++value) {
+            container.addElement(value * 3 - 1);
+        }
+        checkJumpsMatchSteps<MagicalContainer::AscendingIterator>(container);
+        checkJumpsMatchSteps<MagicalContainer::SideCrossIterator>(container);
+        checkJumpsMatchSteps<MagicalContainer::PrimeIterator>(container);
+    }
+
+    SUBCASE("Views are random access ranges") {
+        static_assert(std::ranges::random_access_range<MagicalContainer::SideCrossView>);
+        static_assert(std::sized_sentinel_for<std::default_sentinel_t, MagicalContainer::PrimeView::iterator>);
+
+        MagicalContainer container;
+        container.addRange(1, 10);
+        auto cross = container.sideCross();
+        CHECK(cross.begin()[3] == 9);
+        CHECK(std::ranges::distance(cross) == 10);
+        CHECK(*(cross.begin() + 9) == 6);
+        CHECK((std::default_sentinel - (cross.begin() + 4)) == 6);
+
+        vector<int> reversed;
+        std::ranges::copy(container.primes() | std::views::reverse, std::back_inserter(reversed));
+        CHECK(reversed == vector<int>{7, 5, 3, 2});
+    }
+
+    SUBCASE("Standard algorithms accept the classic iterators") {
+        static_assert(std::input_iterator<MagicalContainer::AscendingIterator>);
+        static_assert(std::input_iterator<MagicalContainer::SideCrossIterator>);
+        static_assert(std::input_iterator<MagicalContainer::PrimeIterator>);
+        static_assert(std::is_same_v<std::iterator_traits<MagicalContainer::SideCrossIterator>::iterator_category,
+                                     std::iterator_traits<MagicalContainer::SideCrossView::iterator>::iterator_category>);
+
+        MagicalContainer container;
+        container.addRange(1, 10);
+        MagicalContainer::AscendingIterator ascIt(container);
+        MagicalContainer::SideCrossIterator sideCrossIt(container);
+        MagicalContainer::PrimeIterator primeIt(container);
+        MagicalContainer::SideCrossIterator endIt(container);
+        endIt.end();
+
+        CHECK(std::distance(sideCrossIt, endIt) == 10);
+        CHECK(std::distance(ascIt.begin(), MagicalContainer::AscendingIterator(container).end()) == 10);
+        CHECK(std::distance(primeIt.begin(), MagicalContainer::PrimeIterator(container).end()) == 4);
+
+        std::advance(sideCrossIt, 3);
+        CHECK(*sideCrossIt == 9);
+        CHECK(*sideCrossIt++ == 9);
+        CHECK(*sideCrossIt == 3);
+        CHECK(*std::next(ascIt, 4) == 5);
+        vector<int> primes;
+        std::copy(primeIt.begin(), MagicalContainer::PrimeIterator(container).end(), std::back_inserter(primes));
+        CHECK(primes == vector<int>{2, 3, 5, 7});
+    }
+}
+
+TEST_CASE("BlockedSortedStorage matches a sorted set") {
+    BlockedSortedStorage<int, 8> storage;
+    std::set<int> reference;
+    mt19937 gen(11);
+    uniform_int_distribution<int> value(-300, 300);
+
+    bool allMatch = true;
+    for (int step = 0; step < 5000; ++step) {
+        int key = value(gen);
+        if (gen() % 3 == 0) {
+            allMatch = allMatch && storage.erase(key) == (reference.erase(key) == 1);
+        } else {
+            allMatch = allMatch && storage.insert(key) == reference.insert(key).second;
+        }
+        allMatch = allMatch && storage.size() == reference.size();
+    }
+    CHECK(allMatch);
+    CHECK(vector<int>(storage.begin(), storage.end()) == vector<int>(reference.begin(), reference.end()));
+
+    bool ranksMatch = true;
+    size_t rank = 0;
+    for (int key : reference) {
+        ranksMatch = ranksMatch && storage[rank] == key && storage.lowerBound(key) == rank && storage.contains(key);
+        ++rank;
+    }
+    CHECK(ranksMatch);
+    CHECK(storage.lowerBound(1000) == storage.size());
+    CHECK_FALSE(storage.contains(1000));
+
+    storage.assign({1, 3, 5, 7, 9, 11, 13, 15, 17, 19});
+    CHECK(storage.size() == 10);
+    CHECK(storage[7] == 15);
+    CHECK(storage.lowerBound(6) == 3);
+    CHECK(storage.blockCount() == 3);
+}
+
+TEST_CASE("BlockedSortedStorage keeps prime tags with their values") {
+    // 200-slot blocks span four bitmap words, so tags cross word boundaries
+    BlockedSortedStorage<int, 200> storage;
+    std::set<int> reference;
+    mt19937 gen(5);
+    uniform_int_distribution<int> value(0, 6000);
+
+    for (int step = 0; step < 20000; ++step) {
+        int key = value(gen);
+        if (gen() % 3 == 0) {
+            storage.erase(key);
+            reference.erase(key);
+        } else {
+            storage.insert(key, MagicalContainer::isPrime(key));
+            reference.insert(key);
+        }
+    }
+    CHECK(storage.blockCount() > 4);
+
+    vector<int> expected;
+    std::copy_if(reference.begin(), reference.end(), std::back_inserter(expected), MagicalContainer::isPrime);
+    REQUIRE(storage.primeCount() == expected.size());
+    size_t mismatches = 0;
+    for (size_t k = 0; k < expected.size(); ++k) {
+        size_t rank = storage.primeRank(k);
+        mismatches += storage.primeAt(k) != expected[k] || storage[rank] != expected[k] || storage.primesBefore(rank) != k ? 1U : 0U;
+    }
+    CHECK(mismatches == 0);
+    CHECK(storage.primesBefore(storage.size()) == expected.size());
+
+    storage.eraseRange(10, storage.size() - 10);
+    size_t tagged = 0;
+    storage.forEachTagged([&](int key, bool prime) { mismatches += prime != MagicalContainer::isPrime(key) ? 1U : 0U; tagged += prime; });
+    CHECK(mismatches == 0);
+    CHECK(tagged == storage.primeCount());
+}
+
+TEST_CASE("BlockedSortedStorage erases keep blocks a quarter full") {
+    BlockedSortedStorage<int, 16> storage;
+    vector<int> keys;
+    for (int key = 0; key < 4000; ++key) {
+        storage.insert(key, MagicalContainer::isPrime(key));
+        keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), mt19937(3));
+    keys.resize(3600);
+
+    size_t underfull = 0;
+    for (int key : keys) {
+        storage.erase(key);
+        for (size_t block = 0; block < storage.blockCount() && storage.blockCount() > 1; ++block) {
+            underfull += storage.block(block).size() < 4 ? 1U : 0U;
+        }
+    }
+    CHECK(underfull == 0);
+    CHECK(storage.size() == 400);
+
+    size_t mismatches = 0;
+    size_t tagged = 0;
+    storage.forEachTagged([&](int key, bool prime) { mismatches += prime != MagicalContainer::isPrime(key) ? 1U : 0U; tagged += prime; });
+    CHECK(mismatches == 0);
+    CHECK(tagged == storage.primeCount());
+}
+
+TEST_CASE("Storage cursors follow steps, jumps and writes") {
+    BlockedSortedStorage<int, 8> storage;
+    vector<int> values(1000);
+    vector<uint8_t> primeFlags(values.size());
+    for (size_t idx = 0; idx < values.size(); ++idx) {
+        values[idx] = static_cast<int>(idx) * 3;
+        primeFlags[idx] = MagicalContainer::isPrime(values[idx]) ? 1 : 0;
+    }
+    storage.assign(values, primeFlags);
+
+    // Runs of forward and backward steps broken by random jumps
+    mt19937 gen(3);
+    BlockedSortedStorage<int, 8>::Cursor cursor;
+    BlockedSortedStorage<int, 8>::Cursor primeCursor;
+    size_t mismatches = 0;
+    size_t rank = 0;
+    size_t k = 0;
+    for (int step = 0; step < 5000; ++step) {
+        if (step % 3 == 2) {
+            // A write between lookups leaves both cursors stale
+            int key = static_cast<int>(gen() % 3000);
+            if (!storage.erase(key)) {
+                storage.insert(key, MagicalContainer::isPrime(key));
+            }
+        }
+        unsigned move = gen() % 10;
+        rank = move == 0 ? gen() % storage.size() : move < 6 ? std::min(rank + 1, storage.size() - 1) : rank - (rank > 0);
+        k = move == 0 ? gen() % storage.primeCount() : move < 6 ? std::min(k + 1, storage.primeCount() - 1) : k - (k > 0);
+        mismatches += storage.at(rank, cursor) != storage[rank] || storage.primeAt(k, primeCursor) != storage.primeAt(k) ? 1U : 0U;
+    }
+    CHECK(mismatches == 0);
+
+    SUBCASE("View iterators see writes made after their last step") {
+        BasicMagicalContainer<int, BlockedStorage<4>> container;
+        container.addRange(10, 40);
+        auto ascending = container.ascending().begin() + 20;
+        auto primes = container.primes().begin() + 3;
+        CHECK(*ascending == 30);
+        CHECK(*primes == 19);
+        container.removeRange(10, 12);
+        container.addElement(1);
+        CHECK(*ascending == 32);
+        CHECK(*primes == 23);
+    }
+}
+
+TEST_CASE("removeElements") {
+    MagicalContainer container;
+    container.addRange(1, 30);
+
+    SUBCASE("Removes a batch in one pass and keeps the prime index aligned") {
+        vector<int> batch = {29, 4, 2, 100, 4, 15, 1, 30};
+        CHECK(container.removeElements(batch) == 6);
+        CHECK(container.size() == 24);
+        CHECK(container.getVec().front() == 3);
+        CHECK(container.getVec().back() == 28);
+
+        vector<int> primes;
+        std::ranges::copy(container.primes(), std::back_inserter(primes));
+        CHECK(primes == vector<int>{3, 5, 7, 11, 13, 17, 19, 23});
+    }
+
+    SUBCASE("Matches removing one by one") {
+        MagicalContainer single;
+        single.addRange(1, 30);
+        vector<int> batch;
+        for (int value = 3; value <= 30; value += 4) {
+            batch.push_back(value);
+            single.removeElement(value);
+        }
+        CHECK(container.removeElements(batch) == batch.size());
+        CHECK(container.getVec() == single.getVec());
+        CHECK(container.getPrime() == single.getPrime());
+        CHECK(container.removeElements(batch) == 0);
+        CHECK(container.removeElements({}) == 0);
+    }
+}
+
+TEST_CASE("removeRange and removeIf") {
+    MagicalContainer container;
+    container.addRange(-10, 40);
+
+    SUBCASE("removeRange erases the band and keeps the prime index aligned") {
+        CHECK(container.removeRange(5, 20) == 16);
+        CHECK(container.size() == 35);
+        vector<int> primes;
+        std::ranges::copy(container.primes(), std::back_inserter(primes));
+        CHECK(primes == vector<int>{2, 3, 23, 29, 31, 37});
+        CHECK(container.removeRange(5, 20) == 0);
+        CHECK(container.removeRange(30, 29) == 0);
+        CHECK(container.removeRange(-100, 100) == 35);
+        CHECK(container.size() == 0);
+        CHECK(container.getPrime().empty());
+    }
+
+    SUBCASE("removeIf compacts in one pass") {
+        CHECK(container.removeIf([](int value) { return value % 3 == 0; }) == 17);
+        CHECK(container.size() == 34);
+        CHECK(std::ranges::none_of(container.ascending(), [](int value) { return value % 3 == 0; }));
+        vector<int> primes;
+        std::ranges::copy(container.primes(), std::back_inserter(primes));
+        CHECK(primes == vector<int>{2, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37});
+        CHECK(container.removeIf([](int) { return false; }) == 0);
+    }
+}
+
+TEST_CASE("Non-throwing contains and tryRemove") {
+    MagicalContainer container;
+    container.addRange(1, 10);
+
+    CHECK(container.contains(7));
+    CHECK_FALSE(container.contains(11));
+    CHECK(container.tryRemove(7));
+    CHECK_FALSE(container.tryRemove(7));
+    CHECK_FALSE(container.contains(7));
+    CHECK(container.size() == 9);
+    CHECK(container.getPrime().size() == 3);
+    CHECK_THROWS_AS(container.removeElement(7), runtime_error);
+}
+
+// Walks Checked and Unchecked iterators of one kind side by side
+template <typename Checked, typename Unchecked>
+bool uncheckedWalkMatches(MagicalContainer &container)
+{
+    Checked checked(container);
+    Unchecked unchecked(container);
+    auto it = checked.begin();
+    for (auto fast = unchecked.begin(); fast != unchecked.end(); ++fast, ++it)
+    {
+        if (it == checked.end() || *it != *fast)
+        {
+            return false;
+        }
+    }
+    return it == checked.end();
+}
+
+TEST_CASE("Unchecked iteration policy") {
+    MagicalContainer container;
+    container.addRange(1, 30);
+
+    static_assert(!std::is_same_v<MagicalContainer::AscendingIterator, MagicalContainer::UncheckedAscendingIterator>);
+    CHECK(uncheckedWalkMatches<MagicalContainer::AscendingIterator, MagicalContainer::UncheckedAscendingIterator>(container));
+    CHECK(uncheckedWalkMatches<MagicalContainer::SideCrossIterator, MagicalContainer::UncheckedSideCrossIterator>(container));
+    CHECK(uncheckedWalkMatches<MagicalContainer::PrimeIterator, MagicalContainer::UncheckedPrimeIterator>(container));
+
+    // Both policies in one program: the checked iterator still throws
+    MagicalContainer::UncheckedPrimeIterator fast(container);
+    CHECK(*(fast.begin() += 2) == 5);
+    MagicalContainer::PrimeIterator checked(container);
+    CHECK_THROWS_AS(++checked.end(), runtime_error);
+}
+
+// Mixed workload on a policy instantiation, checked against std::set
+template <typename Container>
+void checkPoliciesMatchSet(typename Container::value_type low, typename Container::value_type high)
+{
+    using T = typename Container::value_type;
+    Container container;
+    std::set<T> reference;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int64_t> pick(int64_t{low}, int64_t{high});
+
+    size_t removeMismatches = 0;
+    for (int round = 0; round < 3000; ++round)
+    {
+        auto value = static_cast<T>(pick(rng));
+        if (round % 3 == 2)
+        {
+            removeMismatches += container.tryRemove(value) != (reference.erase(value) == 1) ? 1U : 0U;
+        }
+        else
+        {
+            container.addElement(value);
+            reference.insert(value);
+        }
+    }
+    CHECK(removeMismatches == 0);
+    vector<T> batch;
+    for (int idx = 0; idx < 500; ++idx)
+    {
+        batch.push_back(static_cast<T>(pick(rng)));
+    }
+    container.addElements(std::span<const T>(batch));
+    reference.insert(batch.begin(), batch.end());
+    container.addRange(static_cast<T>(low + 10), static_cast<T>(low + 40));
+    for (auto value = int64_t{low} + 10; value <= int64_t{low} + 40; ++value)
+    {
+        reference.insert(static_cast<T>(value));
+    }
+    auto middle = static_cast<T>(low / 2 + high / 2);
+    container.removeRange(middle, static_cast<T>(middle + 20));
+    std::erase_if(reference, [middle](T value) { return value >= middle && value <= middle + 20; });
+
+    vector<T> ascending;
+    std::ranges::copy(container.ascending(), std::back_inserter(ascending));
+    CHECK(ascending == vector<T>(reference.begin(), reference.end()));
+
+    vector<T> primes;
+    std::ranges::copy(container.primes(), std::back_inserter(primes));
+    vector<T> expectedPrimes;
+    std::ranges::copy_if(reference, std::back_inserter(expectedPrimes), [](T value)
+                         { return value >= 2 && isPrimeTrialDivision(static_cast<uint64_t>(value)); });
+    CHECK(primes == expectedPrimes);
+    CHECK(container.size() == reference.size());
+}
+
+TEST_CASE("Policy instantiations match a sorted set") {
+    checkPoliciesMatchSet<MagicalContainer>(-2000, 2000);
+    checkPoliciesMatchSet<BasicMagicalContainer<int16_t>>(-3000, 3000);
+    checkPoliciesMatchSet<BasicMagicalContainer<uint32_t, BlockedStorage<16>>>(4000000000U, 4000005000U);
+    checkPoliciesMatchSet<BasicMagicalContainer<int64_t, VectorStorage, TrialDivisionPrimality>>(1000000000000LL, 1000000004000LL);
+    checkPoliciesMatchSet<BasicMagicalContainer<int, BlockedStorage<8>, MillerRabinPrimality, SharedMutexLock>>(-500, 5000);
+    checkPoliciesMatchSet<BasicMagicalContainer<int, BlockedStorage<256>>>(-2000, 6000);
+    checkPoliciesMatchSet<BasicMagicalContainer<int, IndexedStorage<16>>>(-2000, 2000);
+    checkPoliciesMatchSet<BasicMagicalContainer<int64_t, IndexedStorage<16>, MillerRabinPrimality, SharedMutexLock>>(-2000, 2000);
+
+    SUBCASE("Legacy iterators work over blocked storage") {
+        BasicMagicalContainer<int64_t, BlockedStorage<4>> container;
+        container.addRange(1, 9);
+        vector<int64_t> sideCross;
+        BasicMagicalContainer<int64_t, BlockedStorage<4>>::SideCrossIterator crossIter(container);
+        for (auto it = crossIter.begin(); it != crossIter.end(); ++it)
+        {
+            sideCross.push_back(*it);
+        }
+        CHECK(sideCross == vector<int64_t>{1, 9, 2, 8, 3, 7, 4, 6, 5});
+        CHECK(container.getStorage().blockCount() > 1);
+    }
+
+    SUBCASE("Crossed assignFrom calls do not deadlock") {
+        using Locked = BasicMagicalContainer<int, VectorStorage, MillerRabinPrimality, SharedMutexLock>;
+        Locked first;
+        Locked second;
+        first.addRange(1, 50);
+        second.addRange(100, 120);
+        std::thread forward([&]
+                            {
+                                for (int round = 0; round < 2000; ++round)
+                                {
+                                    first.assignFrom(second);
+                                } });
+        std::thread backward([&]
+                             {
+                                 for (int round = 0; round < 2000; ++round)
+                                 {
+                                     second.assignFrom(first);
+                                 } });
+        forward.join();
+        backward.join();
+        first.assignFrom(first);
+        CHECK(first.size() == second.size());
+    }
+}
+
+TEST_CASE("64-bit primality and MagicalContainer64") {
+    SUBCASE("isPrime64 agrees with trial division") {
+        std::mt19937_64 rng(11);
+        size_t mismatches = 0;
+        for (uint64_t number = (uint64_t{1} << 32) - 2000; number < (uint64_t{1} << 32) + 20000; ++number)
+        {
+            mismatches += isPrime64(number) != isPrimeTrialDivision(number) ? 1U : 0U;
+        }
+        for (int round = 0; round < 300; ++round)
+        {
+            uint64_t number = rng() >> 24U; // up to 2^40, cheap enough for trial division
+            mismatches += isPrime64(number) != isPrimeTrialDivision(number) ? 1U : 0U;
+        }
+        CHECK(mismatches == 0);
+    }
+
+    SUBCASE("Known 64-bit primes and strong pseudoprimes") {
+        CHECK(isPrime64(2305843009213693951ULL));  // 2^61 - 1
+        CHECK(isPrime64(18446744073709551557ULL)); // largest prime below 2^64
+        CHECK_FALSE(isPrime64(18446744073709551615ULL));
+        CHECK_FALSE(isPrime64(3825123056546413051ULL)); // strong pseudoprime to bases 2..23
+        CHECK_FALSE(isPrime64(4611686014132420609ULL)); // (2^31 - 1)^2
+        CHECK_FALSE(isPrime64(1000000016000000063ULL)); // 1000000007 * 1000000009
+    }
+
+    SUBCASE("Iteration keeps its semantics above the int range") {
+        MagicalContainer64 container;
+        const int64_t base = int64_t{1} << 40;
+        container.addRange(base, base + 100);
+        container.addElement(-5);
+        container.addElement(2305843009213693951LL);
+        container.removeRange(base + 50, base + 100);
+
+        vector<int64_t> primes;
+        std::ranges::copy(container.primes(), std::back_inserter(primes));
+        vector<int64_t> expected;
+        for (int64_t value = base; value < base + 50; ++value)
+        {
+            if (isPrimeTrialDivision(static_cast<uint64_t>(value)))
+            {
+                expected.push_back(value);
+            }
+        }
+        expected.push_back(2305843009213693951LL);
+        CHECK(primes == expected);
+
+        MagicalContainer64::SideCrossIterator crossIter(container);
+        auto it = crossIter.begin();
+        CHECK(*it == -5);
+        ++it;
+        CHECK(*it == 2305843009213693951LL);
+        ++it;
+        CHECK(*it == base);
+        CHECK(container.size() == 52);
+    }
+
+    SUBCASE("uint64_t elements") {
+        BasicMagicalContainer<uint64_t> container;
+        vector<uint64_t> values{18446744073709551557ULL, 18446744073709551615ULL, 3825123056546413051ULL, 7};
+        container.addElements(std::span<const uint64_t>(values));
+        vector<uint64_t> primes;
+        std::ranges::copy(container.primes(), std::back_inserter(primes));
+        CHECK(primes == vector<uint64_t>{7, 18446744073709551557ULL});
+        CHECK(container.ascending()[3] == 18446744073709551615ULL);
+    }
+}
+
+TEST_CASE("ConcurrentMagicalContainer snapshots") {
+    ConcurrentMagicalContainer container;
+    CHECK(container.publishInterval() == 1);
+    container.addRange(1, 10);
+    CHECK(container.size() == 10);
+    CHECK(container.contains(10));
+    auto before = container.snapshot();
+    CHECK(before->size() == 10);
+
+    SUBCASE("A held snapshot does not see later writes") {
+        container.addElement(11);
+        CHECK(container.tryRemove(2));
+        CHECK(container.size() == 10);
+        CHECK(container.contains(11));
+        CHECK_FALSE(container.contains(2));
+        vector<int> held;
+        std::ranges::copy(before->primes(), std::back_inserter(held));
+        CHECK(held == vector<int>{2, 3, 5, 7});
+        CHECK(before->contains(2));
+        CHECK_THROWS_AS(container.removeElement(2), runtime_error);
+    }
+
+    SUBCASE("Writes wait for the publish interval") {
+        container.setPublishInterval(3);
+        uint64_t version = container.version();
+        container.addElement(20);
+        container.addElement(21);
+        CHECK_FALSE(container.contains(20));
+        container.addElement(22);
+        CHECK(container.contains(22));
+        container.addElement(23);
+        container.publish();
+        CHECK(container.contains(23));
+        CHECK(container.version() == version + 2);
+    }
+
+    SUBCASE("Readers see consistent versions while a writer streams") {
+        std::atomic<bool> done{false};
+        std::atomic<size_t> badSnapshots{0};
+        auto reader = [&]
+        {
+            while (!done.load())
+            {
+                auto snapshot = container.snapshot();
+                bool sorted = std::ranges::is_sorted(snapshot->ascending());
+                bool primesPrime = std::ranges::all_of(snapshot->primes(), [](int value)
+                                                       { return MagicalContainer::isPrime(value); });
+                badSnapshots += (sorted && primesPrime) ? 0U : 1U;
+            }
+        };
+        std::thread first(reader);
+        std::thread second(reader);
+        // Every write is published within 16 writes
+        container.setPublishInterval(16);
+        size_t unpublished = 0;
+        for (int value = 11; value <= 3000; ++value)
+        {
+            container.addElement(value);
+            unpublished += container.contains(std::max(value - 16, 1)) ? 0U : 1U;
+        }
+        container.publish();
+        done = true;
+        first.join();
+        second.join();
+        CHECK(badSnapshots == 0);
+        CHECK(unpublished == 0);
+        CHECK(container.size() == 3000);
+        CHECK(before->size() == 10);
+    }
+}
+
+TEST_CASE("ShardedMagicalContainer matches MagicalContainer") {
+    ShardedMagicalContainer sharded(8, 0, 999);
+    MagicalContainer single;
+    CHECK(sharded.shardCount() == 8);
+    CHECK(std::ranges::empty(sharded.sideCross()));
+
+    vector<int> values = {-50, 5000, 0, 999, 124, 125, 126, 3, 1, 997};
+    for (int value : values)
+    {
+        sharded.addElement(value);
+        single.addElement(value);
+    }
+    vector<int> batch{2, 250, 251, 500, 7, 7, 11};
+    sharded.addElements(std::span<const int>(batch));
+    single.addElements(std::span<const int>(batch));
+    sharded.addRange(120, 260);
+    single.addRange(120, 260);
+    CHECK(sharded.removeRange(200, 255) == single.removeRange(200, 255));
+    CHECK(sharded.tryRemove(126) == single.tryRemove(126));
+    CHECK(sharded.removeIf([](int value) { return value % 10 == 3; }) == single.removeIf([](int value) { return value % 10 == 3; }));
+
+    auto collect = [](auto &&range)
+    {
+        vector<int> out;
+        std::ranges::copy(range, std::back_inserter(out));
+        return out;
+    };
+    CHECK(sharded.size() == single.size());
+    CHECK(collect(sharded.ascending()) == collect(single.ascending()));
+    CHECK(collect(sharded.primes()) == collect(single.primes()));
+    CHECK(collect(sharded.sideCross()) == collect(single.sideCross()));
+    CHECK(sharded.shard(0).contains(-50));
+    CHECK(sharded.shard(7).contains(5000));
+    CHECK(sharded.contains(999));
+    CHECK_THROWS_AS(sharded.removeElement(4), runtime_error);
+
+    SUBCASE("Side-cross across shards for every size") {
+        ShardedMagicalContainer small(4, 0, 15);
+        MagicalContainer reference;
+        for (int value = 0; value < 16; value += 3)
+        {
+            small.addElement(value);
+            reference.addElement(value);
+            CHECK(collect(small.sideCross()) == collect(reference.sideCross()));
+        }
+    }
+
+    SUBCASE("Concurrent writers") {
+        ShardedMagicalContainer shared(16, 0, 1 << 16);
+        vector<std::thread> writers;
+        for (int writer = 0; writer < 4; ++writer)
+        {
+            writers.emplace_back([&shared, writer]
+                                 {
+                                     for (int value = writer; value < 20000; value += 4)
+                                     {
+                                         shared.addElement(value);
+                                     } });
+        }
+        for (std::thread &writer : writers)
+        {
+            writer.join();
+        }
+        CHECK(shared.size() == 20000);
+        CHECK(std::ranges::is_sorted(shared.ascending()));
+        CHECK(std::ranges::distance(shared.primes()) == 2262);
+    }
+}
+
+TEST_CASE("IngestingMagicalContainer") {
+    SUBCASE("flush makes every earlier add visible") {
+        std::atomic<size_t> listened{0};
+        IngestingMagicalContainer ingest([&listened](std::span<const int> batch)
+                                         { listened += batch.size(); });
+        ingest.addElement(7);
+        ingest.addElement(7);
+        vector<int> batch{1, 2, 3, 4};
+        ingest.addElements(std::span<const int>(batch));
+        ingest.flush();
+        CHECK(ingest.size() == 5);
+        CHECK(ingest.contains(7));
+        CHECK(listened == 6);
+        CHECK(ingest.mergedBatches() >= 1);
+        vector<int> primes = ingest.read([](const MagicalContainer &container)
+                                         {
+                                             vector<int> out;
+                                             std::ranges::copy(container.primes(), std::back_inserter(out));
+                                             return out; });
+        CHECK(primes == vector<int>{2, 3, 7});
+        ingest.flush();
+        CHECK(ingest.size() == 5);
+    }
+
+    SUBCASE("Many producers") {
+        IngestingMagicalContainer ingest;
+        vector<std::thread> producers;
+        for (int producer = 0; producer < 4; ++producer)
+        {
+            producers.emplace_back([&ingest, producer]
+                                   {
+                                       for (int value = producer; value < 8000; value += 4)
+                                       {
+                                           ingest.addElement(value);
+                                           ingest.addElement(value / 2);
+                                       }
+                                       ingest.flush(); });
+        }
+        for (std::thread &producer : producers)
+        {
+            producer.join();
+        }
+        CHECK(ingest.size() == 8000);
+        CHECK(ingest.read([](const MagicalContainer &container)
+                          { return std::ranges::is_sorted(container.ascending()) && container.primes().size() == 1007; }));
+    }
+
+    SUBCASE("The destructor merges what is still queued") {
+        std::atomic<size_t> listened{0};
+        {
+            IngestingMagicalContainer ingest([&listened](std::span<const int> batch)
+                                             { listened += batch.size(); });
+            for (int value = 0; value < 1000; ++value)
+            {
+                ingest.addElement(value);
+            }
+        }
+        CHECK(listened == 1000);
+    }
+
+    SUBCASE("A throwing listener reaches flush and the merger keeps running") {
+        std::atomic<size_t> listened{0};
+        IngestingMagicalContainer ingest([&listened](std::span<const int> batch)
+                                         {
+                                             if (std::ranges::find(batch, 13) != batch.end())
+                                             {
+                                                 throw std::runtime_error("listener failed");
+                                             }
+                                             listened += batch.size(); });
+        ingest.addElement(13);
+        CHECK_THROWS_AS(ingest.flush(), std::runtime_error);
+        CHECK(ingest.contains(13));
+
+        ingest.addElement(4);
+        CHECK_NOTHROW(ingest.flush());
+        CHECK(ingest.size() == 2);
+        CHECK(listened == 1);
+    }
+}
+
+TEST_CASE("Parallel build") {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> pick(-1000, 100000);
+    vector<int> values(20000);
+    for (int &value : values)
+    {
+        value = pick(rng);
+    }
+    values.insert(values.end(), values.begin(), values.begin() + 500);
+    MagicalContainer reference;
+    reference.addElements(std::span<const int>(values));
+
+    for (unsigned threads : {1U, 2U, 3U, 8U, 0U})
+    {
+        MagicalContainer built;
+        built.addElement(-5000000);
+        built.build(values, threads);
+        CHECK(built.getVec() == reference.getVec());
+        CHECK(built.getPrime() == reference.getPrime());
+    }
+
+    MagicalContainer empty;
+    empty.addRange(1, 10);
+    empty.build({}, 4);
+    CHECK(empty.size() == 0);
+    CHECK(empty.getPrime().empty());
+
+    BasicMagicalContainer<int64_t, BlockedStorage<64>> blocked;
+    vector<int64_t> wide{int64_t{1} << 40, 7, 2305843009213693951LL, 7, 9};
+    blocked.build(wide, 3);
+    vector<int64_t> primes;
+    std::ranges::copy(blocked.primes(), std::back_inserter(primes));
+    CHECK(primes == vector<int64_t>{7, 2305843009213693951LL});
+    CHECK(blocked.size() == 4);
+}
+
+// radixSort against std::sort over the full value range of T
+template <typename T>
+void checkRadixSortMatchesSort(size_t count, unsigned threads)
+{
+    std::mt19937_64 rng(count + threads);
+    vector<T> values(count);
+    for (T &value : values)
+    {
+        value = static_cast<T>(rng());
+    }
+    vector<T> expected = values;
+    std::sort(expected.begin(), expected.end());
+    radixSort(std::span<T>(values), threads);
+    CHECK(values == expected);
+}
+
+TEST_CASE("radixSort") {
+    for (size_t count : {0UL, 1UL, 2UL, 1000UL, 200000UL})
+    {
+        checkRadixSortMatchesSort<int>(count, 1);
+        checkRadixSortMatchesSort<int>(count, 4);
+        checkRadixSortMatchesSort<uint32_t>(count, 3);
+        checkRadixSortMatchesSort<int64_t>(count, 2);
+        checkRadixSortMatchesSort<int16_t>(count, 1);
+    }
+
+    SUBCASE("Sign-flip key orders negatives first") {
+        vector<int> values{0, -1, INT32_MAX, INT32_MIN, 5, -5};
+        radixSort(std::span<int>(values));
+        CHECK(values == vector<int>{INT32_MIN, -5, -1, 0, 5, INT32_MAX});
+        CHECK(radixKey(INT32_MIN) == 0U);
+        CHECK(radixKey(-1) < radixKey(0));
+    }
+
+    SUBCASE("Skipped passes still leave the input sorted") {
+        vector<int> values(5000, 42);
+        values[17] = 7;
+        radixSort(std::span<int>(values), 2);
+        CHECK(values.front() == 7);
+        CHECK(std::is_sorted(values.begin(), values.end()));
+    }
+
+    SUBCASE("Batch paths above the threshold") {
+        vector<int> batch(RADIX_SORT_THRESHOLD * 4);
+        for (size_t idx = 0; idx < batch.size(); ++idx)
+        {
+            batch[idx] = static_cast<int>((idx * 7919) % 3001) - 1500;
+        }
+        MagicalContainer container;
+        container.addElements(std::span<const int>(batch));
+        CHECK(container.size() == 3001);
+        CHECK(container.ascending()[0] == -1500);
+        CHECK(container.removeElements(std::span<const int>(batch)) == 3001);
+    }
+}
+
+TEST_CASE("Sorting network") {
+    std::mt19937 rng(21);
+    size_t mismatches = 0;
+    for (size_t count = 0; count <= SORTING_NETWORK_MAX; ++count)
+    {
+        vector<int> values(count);
+        for (int &value : values)
+        {
+            // Narrow values on odd sizes so batches carry duplicates
+            value = count % 2 == 1 ? static_cast<int>(rng() % 16) : static_cast<int>(rng());
+        }
+        if (count > 2)
+        {
+            values[0] = INT32_MAX;
+            values[1] = INT32_MIN;
+        }
+        vector<int> expected = values;
+        std::sort(expected.begin(), expected.end());
+        vector<int> vectorized = values;
+        sortSmall(vectorized);
+        vector<int> scalar = values;
+        sortSmallScalar(scalar);
+        mismatches += static_cast<size_t>(vectorized != expected) + static_cast<size_t>(scalar != expected);
+    }
+    CHECK(mismatches == 0);
+
+    vector<int> tooLong(SORTING_NETWORK_MAX + 1);
+    CHECK_THROWS_AS(sortSmall(tooLong), std::runtime_error);
+    CHECK_THROWS_AS(sortSmallScalar(tooLong), std::runtime_error);
+
+    SUBCASE("Micro-batches through addElements") {
+        MagicalContainer container;
+        std::set<int> expected;
+        for (int batchIdx = 0; batchIdx < 40; ++batchIdx)
+        {
+            vector<int> batch(static_cast<size_t>(8 + batchIdx * 6));
+            for (int &value : batch)
+            {
+                value = static_cast<int>(rng() % 2000) - 1000;
+                expected.insert(value);
+            }
+            container.addElements(std::span<const int>(batch));
+        }
+        CHECK(container.size() == expected.size());
+        CHECK(std::equal(expected.begin(), expected.end(), container.ascending().begin()));
+    }
+}
+
+template <typename Container>
+void checkContainsBatchMatchesContains(Container &container)
+{
+    vector<int> queries;
+    for (int value = -50; value <= 1050; ++value)
+    {
+        queries.push_back(value);
+    }
+    queries.push_back(INT32_MIN);
+    queries.push_back(INT32_MAX);
+    std::unique_ptr<bool[]> found(new bool[queries.size()]);
+    std::span<bool> out(found.get(), queries.size());
+    container.containsBatch(std::span<const int>(queries), out);
+    size_t mismatches = 0;
+    for (size_t idx = 0; idx < queries.size(); ++idx)
+    {
+        mismatches += static_cast<size_t>(out[idx] != container.contains(queries[idx]));
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("containsBatch") {
+    bool found[3] = {true, true, true};
+    vector<int> none{1, 2, 3};
+
+    SUBCASE("Empty container") {
+        MagicalContainer container;
+        container.containsBatch(std::span<const int>(none), found);
+        CHECK_FALSE(found[0]);
+        CHECK_FALSE(found[2]);
+    }
+
+    SUBCASE("Matches contains across sizes and storages") {
+        for (int count : {1, 2, 3, 17, 500})
+        {
+            MagicalContainer container;
+            BasicMagicalContainer<int, BlockedStorage<8>> blocked;
+            for (int idx = 0; idx < count; ++idx)
+            {
+                container.addElement(idx * 2 + 1);
+                blocked.addElement(idx * 2 + 1);
+            }
+            checkContainsBatchMatchesContains(container);
+            checkContainsBatchMatchesContains(blocked);
+            container.addElement(INT32_MAX);
+            container.addElement(INT32_MIN);
+            checkContainsBatchMatchesContains(container);
+        }
+    }
+
+    SUBCASE("Length mismatch throws") {
+        MagicalContainer container;
+        container.addElement(1);
+        CHECK_THROWS_AS(container.containsBatch(std::span<const int>(none), std::span<bool>(found, 2)), std::runtime_error);
+    }
+
+    SUBCASE("Wrappers forward to the container") {
+        ConcurrentMagicalContainer concurrent;
+        concurrent.addElement(2);
+        concurrent.containsBatch(std::span<const int>(none), found);
+        CHECK((!found[0] && found[1] && !found[2]));
+        IngestingMagicalContainer ingesting;
+        ingesting.addElement(3);
+        ingesting.flush();
+        ingesting.containsBatch(std::span<const int>(none), found);
+        CHECK((!found[0] && !found[1] && found[2]));
+    }
+}
+
+template <typename T>
+void checkSearchTreeMatchesLowerBound(size_t count)
+{
+    vector<T> sorted(count);
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        sorted[idx] = static_cast<T>(idx * 3) - 100;
+    }
+    SearchTree<T> tree;
+    tree.build(sorted);
+    size_t mismatches = 0;
+    vector<T> queries{std::numeric_limits<T>::min(), std::numeric_limits<T>::max()};
+    for (T value = -105; value < static_cast<T>(count * 3); ++value)
+    {
+        queries.push_back(value);
+    }
+    for (T value : queries)
+    {
+        auto expected = static_cast<size_t>(std::lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin());
+        mismatches += static_cast<size_t>(tree.lowerBound(value) != expected);
+        mismatches += static_cast<size_t>(tree.contains(value) != std::binary_search(sorted.begin(), sorted.end(), value));
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("Search tree index") {
+    for (size_t count : {0UL, 1UL, 15UL, 16UL, 17UL, 288UL, 289UL, 5000UL})
+    {
+        checkSearchTreeMatchesLowerBound<int>(count);
+        checkSearchTreeMatchesLowerBound<int64_t>(count);
+    }
+
+    SUBCASE("Largest value is found before the padding") {
+        vector<int> sorted{1, 5, INT32_MAX};
+        SearchTree<int> tree;
+        tree.build(sorted);
+        CHECK(tree.lowerBound(INT32_MAX) == 2);
+        CHECK(tree.lowerBound(6) == 2);
+        CHECK(tree.lowerBound(0) == 0);
+        CHECK(tree.contains(INT32_MAX));
+        CHECK_FALSE(tree.contains(6));
+        vector<int> padded{1, 5};
+        tree.build(padded);
+        CHECK_FALSE(tree.contains(INT32_MAX));
+    }
+
+    SUBCASE("Writes mark the tree stale and lookups rebuild it lazily") {
+        BasicMagicalContainer<int, IndexedStorage<64>> container;
+        container.addRange(0, 1599);
+        CHECK_FALSE(container.getStorage().indexed());
+        // Stale until size / SEARCH_TREE_REBUILD_RATIO lookups have hit it
+        for (size_t lookup = 0; lookup < 1600 / SEARCH_TREE_REBUILD_RATIO; ++lookup)
+        {
+            CHECK(container.contains(static_cast<int>(lookup)));
+        }
+        CHECK(container.getStorage().indexed());
+        CHECK_FALSE(container.contains(1600));
+
+        container.addElement(5000);
+        CHECK_FALSE(container.getStorage().indexed());
+        CHECK(container.contains(5000));
+        container.addElement(5000);
+        container.removeElement(7);
+        CHECK_FALSE(container.contains(7));
+        CHECK(container.size() == 1600);
+    }
+
+    SUBCASE("Small sets never build a tree") {
+        BasicMagicalContainer<int, IndexedStorage<>> container;
+        container.addRange(0, 100);
+        for (int value = 0; value < 1000; ++value)
+        {
+            container.contains(value);
+        }
+        CHECK_FALSE(container.getStorage().indexed());
+    }
+}
+
+template <typename View>
+concept SearchableView = requires(View view) { view.lowerBound(0); };
+
+// Checks the view's searches against a std::set holding the same values
+template <typename View>
+size_t countSearchMismatches(const View &view, const std::set<int> &reference, int low, int high)
+{
+    size_t mismatches = 0;
+    auto atOrEnd = [&view](auto it, auto setIt, const std::set<int> &set)
+    {
+        return setIt == set.end() ? it == view.end() : (it != view.end() && *it == *setIt);
+    };
+    for (int value = low; value <= high; ++value)
+    {
+        mismatches += static_cast<size_t>(!atOrEnd(view.lowerBound(value), reference.lower_bound(value), reference));
+        mismatches += static_cast<size_t>(!atOrEnd(view.upperBound(value), reference.upper_bound(value), reference));
+        auto after = reference.upper_bound(value);
+        auto before = after == reference.begin() ? reference.end() : std::prev(after);
+        mismatches += static_cast<size_t>(!atOrEnd(view.predecessor(value), before, reference));
+    }
+    return mismatches;
+}
+
+TEST_CASE("Value searches on the ascending and prime views") {
+    MagicalContainer container;
+    std::set<int> all;
+    std::set<int> primes;
+    std::mt19937 rng(24);
+    for (int idx = 0; idx < 300; ++idx)
+    {
+        int value = static_cast<int>(rng() % 2000) - 500;
+        container.addElement(value);
+        all.insert(value);
+        if (MagicalContainer::isPrime(value))
+        {
+            primes.insert(value);
+        }
+    }
+    CHECK(countSearchMismatches(container.ascending(), all, -600, 1600) == 0);
+    CHECK(countSearchMismatches(container.primes(), primes, -600, 1600) == 0);
+    // Side-cross order is not sorted by value, so it has no searches
+    static_assert(SearchableView<MagicalContainer::PrimeView>);
+    static_assert(!SearchableView<MagicalContainer::SideCrossView>);
+
+    SUBCASE("Iterators continue from the found position") {
+        MagicalContainer small;
+        small.addRange(10, 30);
+        auto it = small.primes().lowerBound(14);
+        CHECK(*it == 17);
+        CHECK(*++it == 19);
+        CHECK(*small.primes().predecessor(16) == 13);
+        CHECK(small.primes().predecessor(1) == small.primes().end());
+        CHECK(small.primes().upperBound(29) == small.primes().end());
+        CHECK(small.ascending().lowerBound(20) - small.ascending().begin() == 10);
+        CHECK(small.ascending().upperBound(INT32_MAX) == small.ascending().end());
+    }
+
+    SUBCASE("Searches go through the search tree on indexed storage") {
+        BasicMagicalContainer<int, IndexedStorage<16>> indexed;
+        indexed.addRange(0, 999);
+        for (int value = 0; value < 200; ++value)
+        {
+            indexed.contains(value);
+        }
+        CHECK(indexed.getStorage().indexed());
+        CHECK(*indexed.primes().lowerBound(990) == 991);
+        CHECK(*indexed.ascending().predecessor(5000) == 999);
+        CHECK(*indexed.primes().predecessor(996) == 991);
+    }
+}
+
+// Seeks every value in [low, high] and checks that the iterator lands where
+// its own traversal visits the first element >= value
+template <typename Iterator, typename View>
+size_t countSeekMismatches(MagicalContainer &container, const View &view, int low, int high)
+{
+    vector<int> order;
+    std::ranges::copy(view, std::back_inserter(order));
+    vector<int> sorted = order;
+    std::sort(sorted.begin(), sorted.end());
+    size_t mismatches = 0;
+    Iterator it(container);
+    Iterator end(container);
+    end.end();
+    for (int value = low; value <= high; ++value)
+    {
+        it.seek(value);
+        auto expected = std::lower_bound(sorted.begin(), sorted.end(), value);
+        if (expected == sorted.end())
+        {
+            mismatches += static_cast<size_t>(it != end);
+            continue;
+        }
+        bool landed = it != end && it.position() < order.size() && order[it.position()] == *expected && *it == *expected;
+        mismatches += static_cast<size_t>(!landed);
+        mismatches += static_cast<size_t>(*view.seek(value) != *expected);
+    }
+    return mismatches;
+}
+
+TEST_CASE("seek") {
+    for (int count : {0, 1, 2, 7, 8, 41})
+    {
+        MagicalContainer container;
+        for (int idx = 0; idx < count; ++idx)
+        {
+            container.addElement(idx * 5 - 20);
+        }
+        CHECK(countSeekMismatches<MagicalContainer::AscendingIterator>(container, container.ascending(), -30, count * 5) == 0);
+        CHECK(countSeekMismatches<MagicalContainer::SideCrossIterator>(container, container.sideCross(), -30, count * 5) == 0);
+        CHECK(countSeekMismatches<MagicalContainer::PrimeIterator>(container, container.primes(), -30, count * 5) == 0);
+    }
+
+    SUBCASE("Scans resume from the sought position") {
+        MagicalContainer container;
+        container.addRange(1, 10);
+        MagicalContainer::AscendingIterator ascending(container);
+        CHECK(*++ascending.seek(4) == 5);
+        MagicalContainer::PrimeIterator prime(container);
+        CHECK(*prime.seek(4) == 5);
+        CHECK(*++prime == 7);
+        // Side-cross order is 1 10 2 9 3 8 4 7 5 6
+        MagicalContainer::SideCrossIterator cross(container);
+        CHECK(cross.seek(8).position() == 5);
+        CHECK(*++cross == 4);
+        CHECK(cross.seek(3).position() == 4);
+        CHECK(cross.seek(11) == MagicalContainer::SideCrossIterator(container).end());
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef BATCHSEARCH_HPP
+#define BATCHSEARCH_HPP
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+namespace ariel
+{
+    // Queries searched side by side by batchContains; enough independent
+    // loads in flight to cover DRAM latency without spilling the cursors
+    constexpr size_t BATCH_SEARCH_LANES = 16;
+
+    // found[i] = whether queries[i] is in sorted, which must be ascending.
+    // Queries run BATCH_SEARCH_LANES at a time through a branchless binary
+    // search: every query in a group shares the same shrinking length, so
+    // each step is one conditional move per query, and both possible probes
+    // of the next step are prefetched while this step's loads complete.
+    // Throws std::runtime_error when queries and found differ in length.
+    template <typename T>
+    void batchContains(std::span<const T> sorted, std::span<const T> queries, std::span<bool> found)
+    {
+        if (queries.size() != found.size())
+        {
+            throw std::runtime_error("batchContains needs one output per query");
+        }
+        if (sorted.empty())
+        {
+            std::fill(found.begin(), found.end(), false);
+            return;
+        }
+
+        const T *data = sorted.data();
+        for (size_t first = 0; first < queries.size(); first += BATCH_SEARCH_LANES)
+        {
+            size_t lanes = std::min(BATCH_SEARCH_LANES, queries.size() - first);
+            const T *base[BATCH_SEARCH_LANES];
+            std::fill(base, base + lanes, data);
+
+            // The lower bound of each query stays within [base, base + length]
+            for (size_t length = sorted.size(); length > 1;)
+            {
+                size_t half = length / 2;
+                size_t nextHalf = (length - half) / 2;
+                for (size_t lane = 0; lane < lanes; ++lane)
+                {
+                    const T *probe = base[lane];
+                    __builtin_prefetch(probe + nextHalf);
+                    __builtin_prefetch(probe + half + nextHalf);
+                    base[lane] = probe[half] < queries[first + lane] ? probe + half : probe;
+                }
+                length -= half;
+            }
+
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                T query = queries[first + lane];
+                const T *candidate = base[lane] + (*base[lane] < query);
+                found[first + lane] = candidate != data + sorted.size() && *candidate == query;
+            }
+        }
+    }
+}
+#endif
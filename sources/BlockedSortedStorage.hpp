@@ -0,0 +1,698 @@
+#ifndef BLOCKEDSORTEDSTORAGE_HPP
+#define BLOCKEDSORTEDSTORAGE_HPP
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ariel
+{
+    // Sorted set of unique values kept in blocks of at most BlockSize
+    // contiguous elements. A value lookup binary-searches the last key of
+    // each block and then the block itself. Insert and erase shift at most
+    // one block. A Fenwick tree over the block sizes turns a rank into its
+    // block in O(log n). A block that overflows is split in two, and an
+    // erase that leaves a block under a quarter full merges it into a
+    // neighbour, or takes values from one too full to merge with. Either way
+    // the per-block arrays are rebuilt in O(n / BlockSize), so insert and
+    // erase cost O(log n + BlockSize) amortized. Ascending traversal stays contiguous
+    // within each block.
+    //
+    // Prime tags live next to the values: each block has a bitmap with one
+    // bit per slot, shifted together with the block, and a second Fenwick
+    // tree counts the tagged values per block. Ranks never need fixing up,
+    // and finding the k-th prime or the primes below a rank is one descent
+    // plus a popcount scan of one bitmap.
+    template <typename T, size_t BlockSize = 1024>
+    class BlockedSortedStorage
+    {
+        static_assert(BlockSize >= 4, "blocks must hold at least four elements");
+
+        // Bitmap words per block, with room for the extra slot of a block
+        // that overflows just before its split
+        static constexpr size_t TAG_WORDS = (BlockSize + 64) / 64;
+
+        using Tags = std::vector<uint64_t>;
+
+        std::vector<std::vector<T>> _blocks; // Never empty blocks
+        std::vector<Tags> _tags;             // Prime bitmap of each block
+        std::vector<T> _blockMax;            // Last key of each block
+        std::vector<size_t> _fenwick;        // 1-based Fenwick tree of block sizes
+        std::vector<size_t> _primeFenwick;   // The same over per-block prime counts
+        size_t _size = 0;
+        size_t _primeCount = 0;
+        size_t _version = 1; // Bumped by every write, so cursors notice they are stale
+
+        static bool tagAt(const Tags &tags, size_t slot) { return ((tags[slot / 64] >> (slot % 64)) & 1U) != 0; }
+
+        static void setTag(Tags &tags, size_t slot) { tags[slot / 64] |= uint64_t{1} << (slot % 64); }
+
+        // Tags set in slots below slot
+        static size_t tagsBefore(const Tags &tags, size_t slot)
+        {
+            size_t count = 0;
+            for (size_t word = 0; word < slot / 64; ++word)
+            {
+                count += static_cast<size_t>(std::popcount(tags[word]));
+            }
+            if (slot % 64 != 0)
+            {
+                count += static_cast<size_t>(std::popcount(tags[slot / 64] & ((uint64_t{1} << (slot % 64)) - 1)));
+            }
+            return count;
+        }
+
+        // Slot of the nth set tag
+        static size_t selectTag(const Tags &tags, size_t nth)
+        {
+            size_t word = 0;
+            for (auto count = static_cast<size_t>(std::popcount(tags[0])); nth >= count; count = static_cast<size_t>(std::popcount(tags[++word])))
+            {
+                nth -= count;
+            }
+            uint64_t bits = tags[word];
+            for (; nth > 0; --nth)
+            {
+                bits &= bits - 1;
+            }
+            return word * 64 + static_cast<size_t>(std::countr_zero(bits));
+        }
+
+        // Slot of the first set tag at or after slot; one must exist
+        static size_t nextTag(const Tags &tags, size_t slot)
+        {
+            size_t word = slot / 64;
+            uint64_t bits = tags[word] & (~uint64_t{0} << (slot % 64));
+            while (bits == 0)
+            {
+                bits = tags[++word];
+            }
+            return word * 64 + static_cast<size_t>(std::countr_zero(bits));
+        }
+
+        // Opens slot for a new tag by moving every later tag up one slot
+        static void insertTag(Tags &tags, size_t slot, bool prime)
+        {
+            size_t word = slot / 64;
+            uint64_t below = (uint64_t{1} << (slot % 64)) - 1;
+            for (size_t upper = tags.size() - 1; upper > word; --upper)
+            {
+                tags[upper] = (tags[upper] << 1U) | (tags[upper - 1] >> 63U);
+            }
+            tags[word] = (tags[word] & below) | ((tags[word] & ~below) << 1U) | (uint64_t{prime} << (slot % 64));
+        }
+
+        // Closes slot by moving every later tag down one slot
+        static void eraseTag(Tags &tags, size_t slot)
+        {
+            size_t word = slot / 64;
+            uint64_t below = (uint64_t{1} << (slot % 64)) - 1;
+            tags[word] = (tags[word] & below) | ((tags[word] >> 1U) & ~below);
+            for (; word + 1 < tags.size(); ++word)
+            {
+                tags[word] |= tags[word + 1] << 63U;
+                tags[word + 1] >>= 1U;
+            }
+        }
+
+        // Tags of slots first .. first + count - 1, moved down to slot 0
+        static Tags sliceTags(const Tags &tags, size_t first, size_t count)
+        {
+            Tags slice(TAG_WORDS, 0);
+            for (size_t slot = 0; slot < count; ++slot)
+            {
+                if (tagAt(tags, first + slot))
+                {
+                    setTag(slice, slot);
+                }
+            }
+            return slice;
+        }
+
+        static void fenwickAdd(std::vector<size_t> &tree, size_t block, ptrdiff_t delta)
+        {
+            for (size_t node = block + 1; node < tree.size(); node += node & (~node + 1))
+            {
+                tree[node] = static_cast<size_t>(static_cast<ptrdiff_t>(tree[node]) + delta);
+            }
+        }
+
+        // Sum over the blocks before block
+        static size_t fenwickPrefix(const std::vector<size_t> &tree, size_t block)
+        {
+            size_t count = 0;
+            for (size_t node = block; node > 0; node -= node & (~node + 1))
+            {
+                count += tree[node];
+            }
+            return count;
+        }
+
+        // Block in which the running sum passes rank, and the rank within it
+        static std::pair<size_t, size_t> fenwickFind(const std::vector<size_t> &tree, size_t rank)
+        {
+            size_t block = 0;
+            size_t step = 1;
+            while (step * 2 < tree.size())
+            {
+                step *= 2;
+            }
+            for (; step > 0; step /= 2)
+            {
+                if (block + step < tree.size() && tree[block + step] <= rank)
+                {
+                    block += step;
+                    rank -= tree[block];
+                }
+            }
+            return {block, rank};
+        }
+
+        void rebuildIndex()
+        {
+            _blockMax.resize(_blocks.size());
+            _fenwick.assign(_blocks.size() + 1, 0);
+            _primeFenwick.assign(_blocks.size() + 1, 0);
+            _primeCount = 0;
+            for (size_t block = 0; block < _blocks.size(); ++block)
+            {
+                size_t primes = primesIn(block);
+                _primeCount += primes;
+                _blockMax[block] = _blocks[block].back();
+                _fenwick[block + 1] += _blocks[block].size();
+                _primeFenwick[block + 1] += primes;
+                size_t parent = (block + 1) + ((block + 1) & (~(block + 1) + 1));
+                if (parent <= _blocks.size())
+                {
+                    _fenwick[parent] += _fenwick[block + 1];
+                    _primeFenwick[parent] += _primeFenwick[block + 1];
+                }
+            }
+        }
+
+        // Moves values, with their tags, between blocks left and left + 1
+        // until the two hold the same number give or take one
+        void evenOut(size_t left)
+        {
+            std::vector<T> &low = _blocks[left];
+            std::vector<T> &high = _blocks[left + 1];
+            size_t half = (low.size() + high.size()) / 2;
+            if (low.size() > half)
+            {
+                // The tail of low moves to the front of high
+                size_t moved = low.size() - half;
+                for (size_t slot = 0; slot < moved; ++slot)
+                {
+                    insertTag(_tags[left + 1], slot, tagAt(_tags[left], half + slot));
+                }
+                _tags[left] = sliceTags(_tags[left], 0, half);
+                high.insert(high.begin(), low.begin() + static_cast<ptrdiff_t>(half), low.end());
+                low.resize(half);
+            }
+            else
+            {
+                // The front of high moves to the end of low
+                size_t moved = half - low.size();
+                for (size_t slot = 0; slot < moved; ++slot)
+                {
+                    if (tagAt(_tags[left + 1], slot))
+                    {
+                        setTag(_tags[left], low.size() + slot);
+                    }
+                }
+                _tags[left + 1] = sliceTags(_tags[left + 1], moved, high.size() - moved);
+                low.insert(low.end(), high.begin(), high.begin() + static_cast<ptrdiff_t>(moved));
+                high.erase(high.begin(), high.begin() + static_cast<ptrdiff_t>(moved));
+            }
+            rebuildIndex();
+        }
+
+        void addToBlock(size_t block, ptrdiff_t delta, ptrdiff_t primeDelta)
+        {
+            fenwickAdd(_fenwick, block, delta);
+            if (primeDelta != 0)
+            {
+                fenwickAdd(_primeFenwick, block, primeDelta);
+                _primeCount = static_cast<size_t>(static_cast<ptrdiff_t>(_primeCount) + primeDelta);
+            }
+        }
+
+        // Elements stored in blocks before block
+        size_t elementsBefore(size_t block) const { return fenwickPrefix(_fenwick, block); }
+
+        // Block holding the element of the given rank, and the rank within it
+        std::pair<size_t, size_t> locate(size_t rank) const { return fenwickFind(_fenwick, rank); }
+
+        // Block holding the k-th prime and its slot there
+        std::pair<size_t, size_t> locatePrime(size_t k) const
+        {
+            auto [block, nth] = fenwickFind(_primeFenwick, k);
+            return {block, selectTag(_tags[block], nth)};
+        }
+
+        // Prime-tagged elements in block
+        size_t primesIn(size_t block) const { return tagsBefore(_tags[block], _blocks[block].size()); }
+
+        // First block whose last key is not below value, or blockCount() when none
+        size_t blockFor(const T &value) const
+        {
+            return static_cast<size_t>(std::lower_bound(_blockMax.begin(), _blockMax.end(), value) - _blockMax.begin());
+        }
+
+        // Removes the element at slot offset of block
+        void eraseIn(size_t block, size_t offset)
+        {
+            ++_version;
+            std::vector<T> &keys = _blocks[block];
+            bool prime = tagAt(_tags[block], offset);
+            keys.erase(keys.begin() + static_cast<ptrdiff_t>(offset));
+            eraseTag(_tags[block], offset);
+            --_size;
+
+            // Merge a block that fell under a quarter full into a neighbour;
+            // when the two do not fit in one block, split their values
+            // evenly instead, leaving both at least half full
+            if (keys.size() < BlockSize / 4 && _blocks.size() > 1)
+            {
+                size_t left = block + 1 < _blocks.size() ? block : block - 1;
+                std::vector<T> &low = _blocks[left];
+                std::vector<T> &high = _blocks[left + 1];
+                if (low.size() + high.size() <= BlockSize)
+                {
+                    for (size_t slot = 0; slot < high.size(); ++slot)
+                    {
+                        if (tagAt(_tags[left + 1], slot))
+                        {
+                            setTag(_tags[left], low.size() + slot);
+                        }
+                    }
+                    low.insert(low.end(), high.begin(), high.end());
+                    _blocks.erase(_blocks.begin() + static_cast<ptrdiff_t>(left) + 1);
+                    _tags.erase(_tags.begin() + static_cast<ptrdiff_t>(left) + 1);
+                    rebuildIndex();
+                    return;
+                }
+                evenOut(left);
+                return;
+            }
+            if (keys.empty())
+            {
+                _blocks.erase(_blocks.begin() + static_cast<ptrdiff_t>(block));
+                _tags.erase(_tags.begin() + static_cast<ptrdiff_t>(block));
+                rebuildIndex();
+                return;
+            }
+            _blockMax[block] = keys.back();
+            addToBlock(block, -1, -static_cast<ptrdiff_t>(prime));
+        }
+
+    public:
+        class const_iterator
+        {
+            const BlockedSortedStorage *_storage = nullptr;
+            size_t _block = 0;
+            size_t _offset = 0;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T *;
+            using reference = const T &;
+
+            const_iterator() = default;
+            const_iterator(const BlockedSortedStorage *storage, size_t block, size_t offset)
+                : _storage(storage), _block(block), _offset(offset) {}
+
+            reference operator*() const { return _storage->_blocks[_block][_offset]; }
+            pointer operator->() const { return &**this; }
+
+            const_iterator &operator++()
+            {
+                if (++_offset == _storage->_blocks[_block].size())
+                {
+                    ++_block;
+                    _offset = 0;
+                }
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator before = *this;
+                ++*this;
+                return before;
+            }
+
+            bool operator==(const const_iterator &other) const { return _block == other._block && _offset == other._offset; }
+        };
+
+        // Where the last lookup through it landed: a block, the rank of its
+        // first element and the primes before it. at and primeAt step a
+        // cursor to a neighbouring block in O(1), so sequential walks in
+        // either direction skip the Fenwick descent, and primeAt finds the
+        // next prime by scanning on from the last one's slot. A cursor from
+        // before the last write is located afresh.
+        struct Cursor
+        {
+            size_t version = 0;
+            size_t block = 0;
+            size_t first = 0;
+            size_t firstPrime = 0;
+            size_t primes = 0;      // Primes in the block
+            size_t nth = SIZE_MAX;  // Last prime found in the block, counted from its first
+            size_t slot = SIZE_MAX; // and its slot
+        };
+
+        using value_type = T;
+
+        BlockedSortedStorage() = default;
+        BlockedSortedStorage(const BlockedSortedStorage &other) = default;
+
+        // A fresh version, so no cursor taken before the copy still matches
+        BlockedSortedStorage &operator=(const BlockedSortedStorage &other)
+        {
+            if (this != &other)
+            {
+                _blocks = other._blocks;
+                _tags = other._tags;
+                _blockMax = other._blockMax;
+                _fenwick = other._fenwick;
+                _primeFenwick = other._primeFenwick;
+                _size = other._size;
+                _primeCount = other._primeCount;
+                _version = std::max(_version, other._version) + 1;
+            }
+            return *this;
+        }
+
+        ~BlockedSortedStorage() = default;
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        size_t blockCount() const { return _blocks.size(); }
+        const std::vector<T> &block(size_t idx) const { return _blocks[idx]; }
+
+        const_iterator begin() const { return const_iterator(this, 0, 0); }
+        const_iterator end() const { return const_iterator(this, _blocks.size(), 0); }
+
+        // Element of the given rank, O(log n)
+        const T &operator[](size_t rank) const
+        {
+            auto [block, offset] = locate(rank);
+            return _blocks[block][offset];
+        }
+
+        // Element of the given rank; O(1) when rank lies in or next to the
+        // cursor's block, O(log n) otherwise
+        const T &at(size_t rank, Cursor &cursor) const
+        {
+            if (cursor.version != _version || rank - cursor.first >= _blocks[cursor.block].size())
+            {
+                seekRank(cursor, rank);
+            }
+            return _blocks[cursor.block][rank - cursor.first];
+        }
+
+        // Rank of the first element not below value, O(log n)
+        size_t lowerBound(const T &value) const
+        {
+            size_t block = blockFor(value);
+            if (block == _blocks.size())
+            {
+                return _size;
+            }
+            const std::vector<T> &keys = _blocks[block];
+            return elementsBefore(block) + static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), value) - keys.begin());
+        }
+
+        // Rank of the first element above value, O(log n)
+        size_t upperBound(const T &value) const
+        {
+            size_t block = static_cast<size_t>(std::upper_bound(_blockMax.begin(), _blockMax.end(), value) - _blockMax.begin());
+            if (block == _blocks.size())
+            {
+                return _size;
+            }
+            const std::vector<T> &keys = _blocks[block];
+            return elementsBefore(block) + static_cast<size_t>(std::upper_bound(keys.begin(), keys.end(), value) - keys.begin());
+        }
+
+        bool contains(const T &value) const
+        {
+            size_t block = blockFor(value);
+            return block != _blocks.size() && std::binary_search(_blocks[block].begin(), _blocks[block].end(), value);
+        }
+
+        // Number of prime-tagged values
+        size_t primeCount() const { return _primeCount; }
+
+        // Rank of the k-th prime-tagged value, O(log n + BlockSize / 64)
+        size_t primeRank(size_t k) const
+        {
+            auto [block, offset] = locatePrime(k);
+            return elementsBefore(block) + offset;
+        }
+
+        // The k-th prime-tagged value, O(log n + BlockSize / 64)
+        const T &primeAt(size_t k) const
+        {
+            auto [block, offset] = locatePrime(k);
+            return _blocks[block][offset];
+        }
+
+        // The k-th prime-tagged value through a cursor, like at
+        const T &primeAt(size_t k, Cursor &cursor) const
+        {
+            if (cursor.version != _version || k - cursor.firstPrime >= cursor.primes)
+            {
+                seekPrime(cursor, k);
+            }
+            size_t nth = k - cursor.firstPrime;
+            if (nth != cursor.nth)
+            {
+                const Tags &tags = _tags[cursor.block];
+                cursor.slot = nth == cursor.nth + 1 ? nextTag(tags, cursor.slot + 1) : selectTag(tags, nth);
+                cursor.nth = nth;
+            }
+            return _blocks[cursor.block][cursor.slot];
+        }
+
+        // Prime-tagged values ranked below rank, O(log n + BlockSize / 64)
+        size_t primesBefore(size_t rank) const
+        {
+            if (rank >= _size)
+            {
+                return _primeCount;
+            }
+            auto [block, offset] = locate(rank);
+            return fenwickPrefix(_primeFenwick, block) + tagsBefore(_tags[block], offset);
+        }
+
+        // Calls fn(value, prime) for every value in ascending order
+        template <typename Fn>
+        void forEachTagged(Fn fn) const
+        {
+            for (size_t block = 0; block < _blocks.size(); ++block)
+            {
+                for (size_t slot = 0; slot < _blocks[block].size(); ++slot)
+                {
+                    fn(_blocks[block][slot], tagAt(_tags[block], slot));
+                }
+            }
+        }
+
+        // Rank-based forms of insert and erase, so the container can drive
+        // either storage the same way. The rank of an insert is implied by the
+        // value and only documents the caller's intent here.
+        void insertAt(size_t /*rank*/, const T &value, bool prime = false) { insert(value, prime); }
+
+        void eraseAt(size_t rank)
+        {
+            auto [block, offset] = locate(rank);
+            eraseIn(block, offset);
+        }
+
+        void eraseRange(size_t first, size_t last)
+        {
+            retainFrom(first, [last](size_t rank, const T &) { return rank >= last; });
+        }
+
+        // Keeps, from rank first on, the values for which keep(rank, value)
+        // holds, tags included. Rebuilds the blocks once, O(n). Returns how
+        // many were dropped.
+        template <typename Keep>
+        size_t retainFrom(size_t first, Keep keep)
+        {
+            std::vector<T> kept;
+            std::vector<uint8_t> keptPrime;
+            kept.reserve(_size);
+            keptPrime.reserve(_size);
+            size_t rank = 0;
+            forEachTagged([&](const T &value, bool prime)
+                          {
+                              if (rank < first || keep(rank, value))
+                              {
+                                  kept.push_back(value);
+                                  keptPrime.push_back(static_cast<uint8_t>(prime));
+                              }
+                              ++rank; });
+            size_t dropped = _size - kept.size();
+            if (dropped != 0)
+            {
+                assign(kept, keptPrime);
+            }
+            return dropped;
+        }
+
+        // Inserts value, tagged prime or not, unless it is already present;
+        // returns whether it was inserted
+        bool insert(const T &value, bool prime = false)
+        {
+            ++_version;
+            if (_blocks.empty())
+            {
+                _blocks.emplace_back(1, value);
+                _tags.emplace_back(TAG_WORDS, 0).front() = uint64_t{prime};
+                _size = 1;
+                rebuildIndex();
+                return true;
+            }
+
+            size_t block = std::min(blockFor(value), _blocks.size() - 1);
+            std::vector<T> &keys = _blocks[block];
+            auto pos = std::lower_bound(keys.begin(), keys.end(), value);
+            if (pos != keys.end() && *pos == value)
+            {
+                return false;
+            }
+            insertTag(_tags[block], static_cast<size_t>(pos - keys.begin()), prime);
+            keys.insert(pos, value);
+            ++_size;
+
+            if (keys.size() > BlockSize)
+            {
+                // Split the overflowing block in half
+                size_t half = keys.size() / 2;
+                std::vector<T> upper(keys.begin() + static_cast<ptrdiff_t>(half), keys.end());
+                Tags upperTags = sliceTags(_tags[block], half, upper.size());
+                _tags[block] = sliceTags(_tags[block], 0, half);
+                keys.erase(keys.begin() + static_cast<ptrdiff_t>(half), keys.end());
+                _blocks.insert(_blocks.begin() + static_cast<ptrdiff_t>(block) + 1, std::move(upper));
+                _tags.insert(_tags.begin() + static_cast<ptrdiff_t>(block) + 1, std::move(upperTags));
+                rebuildIndex();
+                return true;
+            }
+            _blockMax[block] = keys.back();
+            addToBlock(block, 1, static_cast<ptrdiff_t>(prime));
+            return true;
+        }
+
+        // Removes value when present; returns whether it was removed
+        bool erase(const T &value)
+        {
+            size_t block = blockFor(value);
+            if (block == _blocks.size())
+            {
+                return false;
+            }
+            const std::vector<T> &keys = _blocks[block];
+            auto pos = std::lower_bound(keys.begin(), keys.end(), value);
+            if (pos == keys.end() || *pos != value)
+            {
+                return false;
+            }
+            eraseIn(block, static_cast<size_t>(pos - keys.begin()));
+            return true;
+        }
+
+        // Replaces the contents with a sorted, duplicate-free sequence;
+        // primeFlags[i] != 0 tags sorted[i], and no flags means no primes
+        void assign(const std::vector<T> &sorted, std::span<const uint8_t> primeFlags = {})
+        {
+            ++_version;
+            _blocks.clear();
+            _tags.clear();
+            for (size_t first = 0; first < sorted.size(); first += BlockSize / 2)
+            {
+                size_t last = std::min(first + BlockSize / 2, sorted.size());
+                _blocks.emplace_back(sorted.begin() + static_cast<ptrdiff_t>(first), sorted.begin() + static_cast<ptrdiff_t>(last));
+                Tags &tags = _tags.emplace_back(TAG_WORDS, 0);
+                for (size_t rank = first; rank < std::min(last, primeFlags.size()); ++rank)
+                {
+                    if (primeFlags[rank] != 0)
+                    {
+                        setTag(tags, rank - first);
+                    }
+                }
+            }
+            _size = sorted.size();
+            rebuildIndex();
+        }
+
+        void clear()
+        {
+            ++_version;
+            _blocks.clear();
+            _tags.clear();
+            _size = 0;
+            rebuildIndex();
+        }
+
+    private:
+        void moveCursor(Cursor &cursor, size_t block, size_t first, size_t firstPrime) const
+        {
+            cursor = Cursor{_version, block, first, firstPrime, primesIn(block), SIZE_MAX, SIZE_MAX};
+        }
+
+        // Points cursor at the block holding rank: one step when that block
+        // neighbours the current one, a Fenwick descent otherwise
+        void seekRank(Cursor &cursor, size_t rank) const
+        {
+            if (cursor.version == _version)
+            {
+                size_t block = cursor.block;
+                size_t next = cursor.first + _blocks[block].size();
+                if (rank >= next && block + 1 < _blocks.size() && rank - next < _blocks[block + 1].size())
+                {
+                    moveCursor(cursor, block + 1, next, cursor.firstPrime + cursor.primes);
+                    return;
+                }
+                if (rank < cursor.first && block > 0 && cursor.first - rank <= _blocks[block - 1].size())
+                {
+                    moveCursor(cursor, block - 1, cursor.first - _blocks[block - 1].size(), cursor.firstPrime - primesIn(block - 1));
+                    return;
+                }
+            }
+            auto [block, offset] = locate(rank);
+            moveCursor(cursor, block, rank - offset, fenwickPrefix(_primeFenwick, block));
+        }
+
+        // The same for the block holding the k-th prime
+        void seekPrime(Cursor &cursor, size_t k) const
+        {
+            if (cursor.version == _version)
+            {
+                size_t block = cursor.block;
+                size_t next = cursor.firstPrime + cursor.primes;
+                if (k >= next && block + 1 < _blocks.size() && k - next < primesIn(block + 1))
+                {
+                    moveCursor(cursor, block + 1, cursor.first + _blocks[block].size(), next);
+                    return;
+                }
+                if (k < cursor.firstPrime && block > 0 && cursor.firstPrime - k <= primesIn(block - 1))
+                {
+                    moveCursor(cursor, block - 1, cursor.first - _blocks[block - 1].size(), cursor.firstPrime - primesIn(block - 1));
+                    return;
+                }
+            }
+            auto [block, nth] = fenwickFind(_primeFenwick, k);
+            moveCursor(cursor, block, elementsBefore(block), k - nth);
+        }
+    };
+}
+#endif
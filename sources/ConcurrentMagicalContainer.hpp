@@ -0,0 +1,307 @@
+#ifndef CONCURRENTMAGICALCONTAINER_HPP
+#define CONCURRENTMAGICALCONTAINER_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "MagicalContainer.hpp"
+
+namespace ariel
+{
+    // Grace periods for the read-copy-update scheme below. A reader enters
+    // by bumping the counter of the current epoch's parity in its slot;
+    // threads hash to one of READER_SLOTS cache lines, so readers on
+    // different threads do not write to a shared line. The epoch moves on
+    // only once no reader is left in the parity it is about to reuse, so
+    // two moves after a pointer was unpublished every reader that could
+    // have loaded it has left. Nobody ever waits: a writer just tries to
+    // advance and frees what has become safe.
+    class ReadEpochs
+    {
+        static constexpr size_t READER_SLOTS = 64;
+
+        struct alignas(64) Slot
+        {
+            std::atomic<uint32_t> readers[2] = {0, 0};
+        };
+
+        Slot _slots[READER_SLOTS];
+        std::atomic<uint64_t> _epoch{0};
+
+        static size_t mySlot()
+        {
+            static thread_local const size_t slot = std::hash<std::thread::id>{}(std::this_thread::get_id()) % READER_SLOTS;
+            return slot;
+        }
+
+    public:
+        // Returns the ticket to hand back to leave()
+        size_t enter()
+        {
+            size_t parity = _epoch.load() & 1U;
+            size_t slot = mySlot();
+            _slots[slot].readers[parity].fetch_add(1);
+            return slot * 2 + parity;
+        }
+
+        void leave(size_t ticket) { _slots[ticket / 2].readers[ticket % 2].fetch_sub(1, std::memory_order_release); }
+
+        uint64_t epoch() const { return _epoch.load(); }
+
+        // Moves to the next epoch when no reader is left in its parity and
+        // returns the epoch now current. Callers must be serialised.
+        uint64_t tryAdvance()
+        {
+            uint64_t epoch = _epoch.load();
+            size_t reused = (epoch + 1) & 1U;
+            for (const Slot &slot : _slots)
+            {
+                if (slot.readers[reused].load() != 0)
+                {
+                    return epoch;
+                }
+            }
+            _epoch.store(epoch + 1);
+            return epoch + 1;
+        }
+    };
+
+    // Opt-in reader-writer mode in the read-copy-update style. Writers are
+    // serialised on a mutex and apply their change to a private master
+    // container; every publishInterval() writes the master is copied into a
+    // new immutable version and published through an atomic pointer.
+    // Readers take no lock: size(), contains() and containsBatch() read the
+    // published version inside a ReadEpochs section, and snapshot() copies
+    // its shared_ptr there, so a snapshot stays valid and unchanged for as
+    // long as it is held. A writer retires the pointer it replaced and
+    // frees it at a later publish, once every reader that could have loaded
+    // it has left; the version itself goes when its last snapshot does.
+    //
+    // By default every write is published, so the next reader sees it.
+    // Publishing copies the whole container, O(n); write-heavy callers can
+    // opt into batching with setPublishInterval(n), which leaves up to n - 1
+    // writes invisible until the interval fills or publish() is called.
+    template <typename T = int, typename Storage = VectorStorage, typename PrimePolicy = MillerRabinPrimality>
+    class BasicConcurrentMagicalContainer
+    {
+    public:
+        using container_type = BasicMagicalContainer<T, Storage, PrimePolicy>;
+        using snapshot_type = std::shared_ptr<const container_type>;
+
+    private:
+        // One published version; readers reach the container through it
+        struct Published
+        {
+            snapshot_type snapshot;
+        };
+
+        container_type _master; // Guarded by _writeMutex
+        mutable std::mutex _writeMutex;
+        std::atomic<Published *> _published;
+        mutable ReadEpochs _epochs;
+        std::vector<std::pair<uint64_t, Published *>> _retired; // Unpublished, with their epoch; guarded by _writeMutex
+        std::atomic<uint64_t> _version{0};
+        size_t _publishInterval = 1;
+        size_t _pending = 0;
+
+        void publishLocked()
+        {
+            auto copy = std::make_shared<container_type>();
+            copy->assignFrom(_master);
+            Published *previous = _published.exchange(new Published{std::move(copy)});
+            _retired.emplace_back(_epochs.epoch(), previous);
+            reclaim();
+            _version.fetch_add(1, std::memory_order_release);
+            _pending = 0;
+        }
+
+        // Frees the retired versions no reader can still be looking at
+        void reclaim()
+        {
+            _epochs.tryAdvance();
+            uint64_t epoch = _epochs.tryAdvance();
+            std::erase_if(_retired, [epoch](const std::pair<uint64_t, Published *> &retired)
+                          {
+                              if (retired.first + 2 > epoch)
+                              {
+                                  return false;
+                              }
+                              delete retired.second;
+                              return true; });
+        }
+
+        // Runs read on the published version inside a read section
+        template <typename Read>
+        auto read(Read read) const
+        {
+            size_t ticket = _epochs.enter();
+            struct Leave
+            {
+                ReadEpochs &epochs;
+                size_t ticket;
+                ~Leave() { epochs.leave(ticket); }
+            } leave{_epochs, ticket};
+            return read(*_published.load());
+        }
+
+        // Applies mutate to the master and publishes when the interval is reached
+        template <typename Mutate>
+        auto write(Mutate mutate)
+        {
+            std::lock_guard<std::mutex> guard(_writeMutex);
+            auto publishAfter = [this]
+            {
+                if (++_pending >= _publishInterval)
+                {
+                    publishLocked();
+                }
+            };
+            if constexpr (std::is_void_v<decltype(mutate(_master))>)
+            {
+                mutate(_master);
+                publishAfter();
+            }
+            else
+            {
+                auto result = mutate(_master);
+                publishAfter();
+                return result;
+            }
+        }
+
+    public:
+        BasicConcurrentMagicalContainer() : _published(new Published{std::make_shared<const container_type>()}) {}
+        // Disable copy constructor
+        BasicConcurrentMagicalContainer(const BasicConcurrentMagicalContainer &) = delete;
+
+        // Disable copy assignment operator
+        BasicConcurrentMagicalContainer &operator=(const BasicConcurrentMagicalContainer &) = delete;
+        ~BasicConcurrentMagicalContainer()
+        {
+            for (auto &retired : _retired)
+            {
+                delete retired.second;
+            }
+            delete _published.load();
+        }
+
+        ////////// Writers //////////
+        void addElement(T element)
+        {
+            write([element](container_type &master)
+                  { master.addElement(element); });
+        }
+
+        void addElements(std::span<const T> elements)
+        {
+            write([elements](container_type &master)
+                  { master.addElements(elements); });
+        }
+
+        void addRange(T low, T high)
+        {
+            write([low, high](container_type &master)
+                  { master.addRange(low, high); });
+        }
+
+        bool tryRemove(T element)
+        {
+            return write([element](container_type &master)
+                         { return master.tryRemove(element); });
+        }
+
+        void removeElement(T element)
+        {
+            if (!tryRemove(element))
+            {
+                throw std::runtime_error("Element not found");
+            }
+        }
+
+        size_t removeElements(std::span<const T> elements)
+        {
+            return write([elements](container_type &master)
+                         { return master.removeElements(elements); });
+        }
+
+        size_t removeRange(T low, T high)
+        {
+            return write([low, high](container_type &master)
+                         { return master.removeRange(low, high); });
+        }
+
+        template <typename Predicate>
+        size_t removeIf(Predicate pred)
+        {
+            return write([&pred](container_type &master)
+                         { return master.removeIf(pred); });
+        }
+
+        // Publishes the writes still pending under a larger interval
+        void publish()
+        {
+            std::lock_guard<std::mutex> guard(_writeMutex);
+            if (_pending != 0)
+            {
+                publishLocked();
+            }
+        }
+
+        // Number of writes between two published versions; at least 1,
+        // and 1 by default
+        void setPublishInterval(size_t writes)
+        {
+            std::lock_guard<std::mutex> guard(_writeMutex);
+            _publishInterval = writes == 0 ? 1 : writes;
+        }
+
+        size_t publishInterval() const
+        {
+            std::lock_guard<std::mutex> guard(_writeMutex);
+            return _publishInterval;
+        }
+
+        ////////// Readers //////////
+        // The latest published version; writers never touch it. Bind it to
+        // a local before iterating, since a view does not own the snapshot:
+        //     auto snap = container.snapshot();
+        //     for (int value : snap->ascending()) ...
+        // whereas snapshot()->ascending() in a range-for dangles.
+        snapshot_type snapshot() const
+        {
+            return read([](const Published &published)
+                        { return published.snapshot; });
+        }
+
+        // Number of versions published so far
+        uint64_t version() const { return _version.load(std::memory_order_acquire); }
+
+        // Lookups on the latest published version, without taking a snapshot
+        size_t size() const
+        {
+            return read([](const Published &published)
+                        { return published.snapshot->size(); });
+        }
+
+        bool contains(T element) const
+        {
+            return read([element](const Published &published)
+                        { return published.snapshot->contains(element); });
+        }
+
+        void containsBatch(std::span<const T> elements, std::span<bool> found) const
+        {
+            read([elements, found](const Published &published)
+                 { published.snapshot->containsBatch(elements, found); });
+        }
+    };
+
+    using ConcurrentMagicalContainer = BasicConcurrentMagicalContainer<>;
+}
+#endif
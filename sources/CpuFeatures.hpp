@@ -0,0 +1,21 @@
+#ifndef CPUFEATURES_HPP
+#define CPUFEATURES_HPP
+
+// Internal to the .cpp files with hand-vectorised kernels. MAGICAL_HAVE_AVX2
+// is defined where <immintrin.h> and GCC-style target attributes exist, and
+// cpuHasAvx2() then tells whether the running CPU can execute those kernels;
+// the check runs once per process.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MAGICAL_HAVE_AVX2 1
+
+namespace ariel
+{
+    inline bool cpuHasAvx2()
+    {
+        static const bool hasAvx2 = __builtin_cpu_supports("avx2") != 0;
+        return hasAvx2;
+    }
+}
+#endif
+#endif
@@ -0,0 +1,173 @@
+#ifndef INDEXEDSORTEDSTORAGE_HPP
+#define INDEXEDSORTEDSTORAGE_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+#include "SearchTree.hpp"
+#include "SortedVectorStorage.hpp"
+
+namespace ariel
+{
+    // Once stale, the search tree is rebuilt after size / this many lookups,
+    // so the O(n) rebuild costs each of those lookups a few element copies
+    constexpr size_t SEARCH_TREE_REBUILD_RATIO = 16;
+
+    // SortedVectorStorage plus a SearchTree over it for read-mostly sets.
+    // lowerBound, upperBound and contains descend the tree, one cache line
+    // per level, whenever it is current. Writes only mark it stale; lookups
+    // then fall back to a binary search over the vector, and once enough of
+    // them have hit the stale tree one of them rebuilds it. A loop of
+    // inserts (each doing a lookup) therefore never pays for a rebuild.
+    // Sets below MinSize elements fit in cache and never build a tree.
+    //
+    // Lookups may rebuild from a const method: several readers under the
+    // container's shared lock serialize on an internal mutex, and the tree
+    // is published with a release store, so readers either see the finished
+    // tree or the vector. Writers already hold the container exclusively.
+    template <typename T, size_t MinSize = 4096>
+    class IndexedSortedStorage
+    {
+        SortedVectorStorage<T> _values;
+        mutable SearchTree<T> _tree;
+        mutable std::mutex _treeMutex;
+        mutable std::atomic<bool> _treeCurrent{false};
+        mutable std::atomic<size_t> _staleLookups{0};
+
+        void invalidate()
+        {
+            _treeCurrent.store(false, std::memory_order_relaxed);
+            _staleLookups.store(0, std::memory_order_relaxed);
+        }
+
+        // True when the tree may answer lookups, rebuilding it first when
+        // this is the lookup that crosses the rebuild threshold
+        bool treeReady() const
+        {
+            if (_treeCurrent.load(std::memory_order_acquire))
+            {
+                return true;
+            }
+            if (_values.size() < MinSize ||
+                _staleLookups.fetch_add(1, std::memory_order_relaxed) + 1 < _values.size() / SEARCH_TREE_REBUILD_RATIO)
+            {
+                return false;
+            }
+            std::lock_guard<std::mutex> guard(_treeMutex);
+            if (!_treeCurrent.load(std::memory_order_relaxed))
+            {
+                _tree.build(std::span<const T>(_values.begin(), _values.end()));
+                _treeCurrent.store(true, std::memory_order_release);
+            }
+            return true;
+        }
+
+    public:
+        using value_type = T;
+        using const_iterator = typename SortedVectorStorage<T>::const_iterator;
+        using Cursor = typename SortedVectorStorage<T>::Cursor;
+
+        IndexedSortedStorage() = default;
+
+        // Copies the values only; the copy builds its own tree when read
+        IndexedSortedStorage(const IndexedSortedStorage &other) : _values(other._values) {}
+
+        IndexedSortedStorage &operator=(const IndexedSortedStorage &other)
+        {
+            _values = other._values;
+            invalidate();
+            return *this;
+        }
+
+        ~IndexedSortedStorage() = default;
+
+        size_t size() const { return _values.size(); }
+        bool empty() const { return _values.empty(); }
+
+        const_iterator begin() const { return _values.begin(); }
+        const_iterator end() const { return _values.end(); }
+
+        const T &operator[](size_t rank) const { return _values[rank]; }
+        const T &at(size_t rank, Cursor &cursor) const { return _values.at(rank, cursor); }
+
+        // Whether lookups currently go through the tree
+        bool indexed() const { return _treeCurrent.load(std::memory_order_acquire); }
+
+        size_t lowerBound(const T &value) const
+        {
+            return treeReady() ? _tree.lowerBound(value) : _values.lowerBound(value);
+        }
+
+        size_t upperBound(const T &value) const
+        {
+            if (value == std::numeric_limits<T>::max())
+            {
+                return _values.size();
+            }
+            return lowerBound(static_cast<T>(value + 1));
+        }
+
+        bool contains(const T &value) const
+        {
+            return treeReady() ? _tree.contains(value) : _values.contains(value);
+        }
+
+        size_t primeCount() const { return _values.primeCount(); }
+        size_t primeRank(size_t k) const { return _values.primeRank(k); }
+        const T &primeAt(size_t k) const { return _values.primeAt(k); }
+        const T &primeAt(size_t k, Cursor &cursor) const { return _values.primeAt(k, cursor); }
+        size_t primesBefore(size_t rank) const { return _values.primesBefore(rank); }
+
+        template <typename Fn>
+        void forEachTagged(Fn fn) const
+        {
+            _values.forEachTagged(fn);
+        }
+
+        void insertAt(size_t rank, const T &value, bool prime = false)
+        {
+            _values.insertAt(rank, value, prime);
+            invalidate();
+        }
+
+        void eraseAt(size_t rank)
+        {
+            _values.eraseAt(rank);
+            invalidate();
+        }
+
+        void eraseRange(size_t first, size_t last)
+        {
+            _values.eraseRange(first, last);
+            invalidate();
+        }
+
+        template <typename Keep>
+        size_t retainFrom(size_t first, Keep keep)
+        {
+            size_t dropped = _values.retainFrom(first, keep);
+            if (dropped != 0)
+            {
+                invalidate();
+            }
+            return dropped;
+        }
+
+        void assign(std::vector<T> &&sorted, std::span<const uint8_t> primeFlags = {})
+        {
+            _values.assign(std::move(sorted), primeFlags);
+            invalidate();
+        }
+
+        void clear()
+        {
+            _values.clear();
+            invalidate();
+        }
+    };
+}
+#endif
@@ -0,0 +1,254 @@
+#ifndef INGESTINGMAGICALCONTAINER_HPP
+#define INGESTINGMAGICALCONTAINER_HPP
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "MagicalContainer.hpp"
+
+namespace ariel
+{
+    // Many producers, one writer. addElement and addElements push onto a
+    // lock-free intrusive stack (one compare-and-swap per call); a dedicated
+    // merger thread takes the whole stack with a single exchange, sorts and
+    // dedups the drained values and merges them through the container's bulk
+    // addElements path. Producers never wait for the merger or each other.
+    //
+    // Since nodes are only ever pushed and the stack is only ever taken whole,
+    // the stack has no ABA problem and needs no memory reclamation scheme.
+    // flush() pushes a barrier node and waits until the batch holding it is
+    // merged, so every value the caller added before it is then visible.
+    //
+    // A merge or listener that throws does not stop the merger: the first
+    // such exception is kept and the next flush() rethrows it. A failed
+    // merge skips the listener, and its values are present only as far as
+    // the container's addElements got before throwing.
+    template <typename T = int, typename Storage = VectorStorage, typename PrimePolicy = MillerRabinPrimality>
+    class BasicIngestingMagicalContainer
+    {
+    public:
+        using container_type = BasicMagicalContainer<T, Storage, PrimePolicy>;
+        // Called on the merger thread after each merge with the drained values
+        using MergeListener = std::function<void(std::span<const T>)>;
+
+    private:
+        // A flush() marker. The merger stores the failure next to the promise
+        // and drops its own reference before setting it, so the exception is
+        // released by the thread that handles it.
+        struct Barrier
+        {
+            std::promise<void> merged;
+            std::exception_ptr error;
+        };
+
+        struct Node
+        {
+            T value;
+            Node *next;
+            std::shared_ptr<Barrier> barrier; // Set for flush() markers only
+
+            explicit Node(T element = T{}, Node *link = nullptr) : value(element), next(link), barrier() {}
+        };
+
+        container_type _container;
+        mutable std::shared_mutex _readMutex; // Merger writes under it, read() shares it
+        std::atomic<Node *> _head{nullptr};
+        std::atomic<uint64_t> _pushes{0}; // Bumped after every push, the merger waits on it
+        std::atomic<bool> _stopping{false};
+        std::atomic<uint64_t> _batches{0};
+        MergeListener _listener;
+        std::exception_ptr _error; // First merge failure since the last flush(), merger thread only
+        std::thread _merger;
+
+        // Links the chain first..last in front of the current head
+        void pushChain(Node *first, Node *last)
+        {
+            Node *head = _head.load(std::memory_order_relaxed);
+            do
+            {
+                last->next = head;
+            } while (!_head.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+            _pushes.fetch_add(1, std::memory_order_release);
+            _pushes.notify_one();
+        }
+
+        void mergeBatch(const vector<T> &batch)
+        {
+            {
+                std::unique_lock<std::shared_mutex> guard(_readMutex);
+                _container.addElements(std::span<const T>(batch));
+            }
+            _batches.fetch_add(1, std::memory_order_relaxed);
+            if (_listener)
+            {
+                _listener(batch);
+            }
+        }
+
+        void mergeLoop()
+        {
+            vector<T> batch;
+            vector<std::shared_ptr<Barrier>> barriers;
+            while (true)
+            {
+                uint64_t seen = _pushes.load(std::memory_order_acquire);
+                Node *node = _head.exchange(nullptr, std::memory_order_acquire);
+                if (node == nullptr)
+                {
+                    if (_stopping.load(std::memory_order_acquire))
+                    {
+                        return;
+                    }
+                    _pushes.wait(seen, std::memory_order_acquire);
+                    continue;
+                }
+
+                while (node != nullptr)
+                {
+                    if (node->barrier)
+                    {
+                        barriers.push_back(std::move(node->barrier));
+                    }
+                    else
+                    {
+                        batch.push_back(node->value);
+                    }
+                    Node *next = node->next;
+                    delete node;
+                    node = next;
+                }
+                if (!batch.empty())
+                {
+                    try
+                    {
+                        mergeBatch(batch);
+                    }
+                    catch (...)
+                    {
+                        if (!_error)
+                        {
+                            _error = std::current_exception();
+                        }
+                    }
+                    batch.clear();
+                }
+                if (!barriers.empty())
+                {
+                    for (auto &barrier : barriers)
+                    {
+                        barrier->error = _error;
+                    }
+                    _error = nullptr;
+                    for (auto &barrier : barriers)
+                    {
+                        barrier->merged.set_value();
+                    }
+                    barriers.clear();
+                }
+            }
+        }
+
+    public:
+        // listener, when given, sees every merged batch; it is fixed for the
+        // container's lifetime because the merger thread reads it unguarded
+        explicit BasicIngestingMagicalContainer(MergeListener listener = {})
+            : _listener(std::move(listener)), _merger([this]
+                                                      { mergeLoop(); }) {}
+
+        // Disable copy constructor
+        BasicIngestingMagicalContainer(const BasicIngestingMagicalContainer &) = delete;
+
+        // Disable copy assignment operator
+        BasicIngestingMagicalContainer &operator=(const BasicIngestingMagicalContainer &) = delete;
+
+        // Merges whatever is still queued, then stops the merger
+        ~BasicIngestingMagicalContainer()
+        {
+            _stopping.store(true, std::memory_order_release);
+            _pushes.fetch_add(1, std::memory_order_release);
+            _pushes.notify_one();
+            _merger.join();
+        }
+
+        // Lock-free; the value shows up after the merger's next batch
+        void addElement(T element)
+        {
+            Node *node = new Node(element);
+            pushChain(node, node);
+        }
+
+        // Queues the whole span with a single compare-and-swap
+        void addElements(std::span<const T> elements)
+        {
+            if (elements.empty())
+            {
+                return;
+            }
+            Node *first = nullptr;
+            Node *last = nullptr;
+            for (T element : elements)
+            {
+                first = new Node(element, first);
+                last = last == nullptr ? first : last;
+            }
+            pushChain(first, last);
+        }
+
+        // Returns once everything added before the call has been merged;
+        // rethrows the first merge or listener failure since the last flush()
+        void flush()
+        {
+            auto barrier = std::make_shared<Barrier>();
+            std::future<void> merged = barrier->merged.get_future();
+            Node *marker = new Node();
+            marker->barrier = barrier;
+            pushChain(marker, marker);
+            merged.wait();
+            if (barrier->error)
+            {
+                std::rethrow_exception(std::exchange(barrier->error, nullptr));
+            }
+        }
+
+        // Runs reader(container) under a shared lock, so it never sees a
+        // half-merged batch; the merger waits while readers are inside
+        template <typename Reader>
+        auto read(Reader reader) const
+        {
+            std::shared_lock<std::shared_mutex> guard(_readMutex);
+            return reader(static_cast<const container_type &>(_container));
+        }
+
+        size_t size() const
+        {
+            return read([](const container_type &container)
+                        { return container.size(); });
+        }
+
+        bool contains(T element) const
+        {
+            return read([element](const container_type &container)
+                        { return container.contains(element); });
+        }
+
+        void containsBatch(std::span<const T> elements, std::span<bool> found) const
+        {
+            read([&](const container_type &container)
+                 { container.containsBatch(elements, found); });
+        }
+
+        // Number of non-empty batches merged so far
+        uint64_t mergedBatches() const { return _batches.load(std::memory_order_relaxed); }
+    };
+
+    using IngestingMagicalContainer = BasicIngestingMagicalContainer<>;
+}
+#endif
@@ -1,138 +1,934 @@
 #ifndef MAGICALCONTAINER_HPP
 #define MAGICALCONTAINER_HPP
 #include <vector>
+#include <cstdint>
 #include <cmath>
+#include <functional>
 #include <stdexcept>
 #include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <ranges>
+#include <shared_mutex>
+#include <span>
+#include "BatchSearch.hpp"
+#include "MagicalPolicies.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include "SortingNetwork.hpp"
 
 using namespace std;
 
 namespace ariel
 {
-    class MagicalContainer
+    // A std::ranges::view over a container in the given order. Iterators
+    // are a container pointer, a position and the order's storage cursor,
+    // so they are trivially copyable, and end() is std::default_sentinel.
+    // Like the classic iterators, views follow the container as elements
+    // are added.
+    template <typename Container, typename Order>
+    class MagicalView : public std::ranges::view_interface<MagicalView<Container, Order>>
     {
-        vector<int> _elements;
-        vector<int *> _prime;
+    public:
+        class iterator
+        {
+            const Container *_container = nullptr;
+            size_t _pos = 0;
+            [[no_unique_address]] mutable typename Order::Cursor _cursor{};
+
+        public:
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = typename Container::value_type;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            iterator(const Container *container, size_t pos) : _container(container), _pos(pos) {}
+
+            value_type operator*() const { return Order::at(*_container, _pos, _cursor); }
+            value_type operator[](difference_type steps) const { return *(*this + steps); }
+
+            iterator &operator++()
+            {
+                ++_pos;
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator before = *this;
+                ++_pos;
+                return before;
+            }
+
+            iterator &operator--()
+            {
+                --_pos;
+                return *this;
+            }
+
+            iterator operator--(int)
+            {
+                iterator before = *this;
+                --_pos;
+                return before;
+            }
+
+            iterator &operator+=(difference_type steps)
+            {
+                _pos = static_cast<size_t>(static_cast<difference_type>(_pos) + steps);
+                return *this;
+            }
+
+            iterator &operator-=(difference_type steps) { return *this += -steps; }
+
+            friend iterator operator+(iterator it, difference_type steps) { return it += steps; }
+            friend iterator operator+(difference_type steps, iterator it) { return it += steps; }
+            friend iterator operator-(iterator it, difference_type steps) { return it -= steps; }
+
+            friend difference_type operator-(const iterator &lhs, const iterator &rhs)
+            {
+                return static_cast<difference_type>(lhs._pos) - static_cast<difference_type>(rhs._pos);
+            }
+
+            friend difference_type operator-(std::default_sentinel_t, const iterator &it)
+            {
+                return static_cast<difference_type>(Order::length(*it._container)) - static_cast<difference_type>(it._pos);
+            }
+
+            friend difference_type operator-(const iterator &it, std::default_sentinel_t sentinel) { return -(sentinel - it); }
+
+            size_t position() const { return _pos; }
+
+            bool operator==(const iterator &other) const { return _pos == other._pos; }
+            auto operator<=>(const iterator &other) const { return _pos <=> other._pos; }
+
+            bool operator==(std::default_sentinel_t) const { return _pos == Order::length(*_container); }
+        };
+
+        MagicalView() = default;
+        explicit MagicalView(const Container &container) : _container(&container) {}
+
+        iterator begin() const { return iterator(_container, 0); }
+        std::default_sentinel_t end() const { return std::default_sentinel; }
+        size_t size() const { return Order::length(*_container); }
+
+        // Value searches, for orders sorted by value (ascending and prime).
+        // Each returns an iterator positioned in O(log n), or one equal to
+        // end() when no element qualifies.
+
+        // First element >= value
+        iterator lowerBound(typename Container::value_type value) const
+            requires requires(const Container &container) { Order::lowerBound(container, value); }
+        {
+            return iterator(_container, Order::lowerBound(*_container, value));
+        }
+
+        // First element > value
+        iterator upperBound(typename Container::value_type value) const
+            requires requires(const Container &container) { Order::upperBound(container, value); }
+        {
+            return iterator(_container, Order::upperBound(*_container, value));
+        }
+
+        // Last element <= value
+        iterator predecessor(typename Container::value_type value) const
+            requires requires(const Container &container) { Order::upperBound(container, value); }
+        {
+            size_t pos = Order::upperBound(*_container, value);
+            return iterator(_container, pos == 0 ? Order::length(*_container) : pos - 1);
+        }
+
+        // Iterator at the traversal position of the first element >= value,
+        // in any order; for side-cross that is where the element is visited
+        iterator seek(typename Container::value_type value) const
+        {
+            return iterator(_container, Order::seek(*_container, value));
+        }
+
+    private:
+        const Container *_container = nullptr;
+    };
+
+    // Sorted set of unique T values with ascending, side-cross and prime
+    // traversal. Each policy is fixed at compile time:
+    //   T            any integer type up to 64 bits, signed or unsigned
+    //   Storage      VectorStorage or BlockedStorage<B> (MagicalPolicies.hpp)
+    //   PrimePolicy  MillerRabinPrimality or TrialDivisionPrimality
+    //   LockPolicy   NoLock or SharedMutexLock
+    // MagicalContainer is the all-defaults instantiation.
+    template <typename T = int, typename Storage = VectorStorage, typename PrimePolicy = MillerRabinPrimality, typename LockPolicy = NoLock>
+    class BasicMagicalContainer
+    {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "elements must be integers");
 
     public:
-        MagicalContainer() {}
+        using value_type = T;
+        using storage_type = typename Storage::template type<T>;
+
+    private:
+        storage_type _elements; // Elements with their prime tags
+        PrimePolicy _primality;
+        [[no_unique_address]] mutable LockPolicy _lock;
+
+        void mergeBatch(vector<T> &batch);
+
+        // Sorts and dedups a batch; long batches go through the parallel radix
+        // sort and int micro-batches through the sorting network
+        static void sortUnique(vector<T> &batch)
+        {
+            if (batch.size() >= RADIX_SORT_THRESHOLD)
+            {
+                radixSort(std::span<T>(batch), 0);
+            }
+            else if constexpr (std::is_same_v<T, int>)
+            {
+                if (batch.size() >= SORTING_NETWORK_MIN && batch.size() <= SORTING_NETWORK_MAX)
+                {
+                    sortSmall(std::span<int>(batch));
+                }
+                else
+                {
+                    std::sort(batch.begin(), batch.end());
+                }
+            }
+            else
+            {
+                std::sort(batch.begin(), batch.end());
+            }
+            batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+        }
+
+        // Merges a sorted, duplicate-free run of count values into _elements
+        // in one pass, skipping values already present. valueAt(k) is the k-th
+        // value of the run and primeAt(k) whether it is prime; the old
+        // elements keep their tags.
+        template <typename ValueAt, typename PrimeAt>
+        void mergeRun(size_t count, ValueAt valueAt, PrimeAt primeAt);
+
+        // Drops every element from position first on for which drop(element)
+        // holds, in one compaction pass; the storage carries the prime tags
+        // of the kept elements along. Returns the number of elements dropped.
+        template <typename Drop>
+        size_t compactFrom(size_t first, Drop drop)
+        {
+            return _elements.retainFrom(first, [&drop](size_t, const T &element)
+                                        { return !drop(element); });
+        }
+
+    public:
+        BasicMagicalContainer() {}
         // Disable copy constructor
-        MagicalContainer(const MagicalContainer &) = delete;
+        BasicMagicalContainer(const BasicMagicalContainer &) = delete;
 
         // Disable copy assignment operator
-        MagicalContainer &operator=(const MagicalContainer &) = delete;
+        BasicMagicalContainer &operator=(const BasicMagicalContainer &) = delete;
         // Disable move constructor
-        MagicalContainer(MagicalContainer &&) = delete;
+        BasicMagicalContainer(BasicMagicalContainer &&) = delete;
 
         // Disable move assignment operator
-        MagicalContainer &operator=(MagicalContainer &&) = delete;
-        ~MagicalContainer()
+        BasicMagicalContainer &operator=(BasicMagicalContainer &&) = delete;
+        ~BasicMagicalContainer() = default;
+
+        // Replaces the contents with a copy of other's elements and prime
+        // index. Copying is O(n), so it is a named call rather than a copy
+        // constructor; primality caches are not copied.
+        void assignFrom(const BasicMagicalContainer &other)
+        {
+            if (this == &other)
+            {
+                return;
+            }
+            // Lock in address order, so a = b racing b = a cannot deadlock
+            std::shared_lock<LockPolicy> theirs(other._lock, std::defer_lock);
+            std::unique_lock<LockPolicy> mine(_lock, std::defer_lock);
+            if (std::less<const BasicMagicalContainer *>{}(this, &other))
+            {
+                mine.lock();
+                theirs.lock();
+            }
+            else
+            {
+                theirs.lock();
+                mine.lock();
+            }
+            _elements = other._elements;
+        }
+
+        void addElement(T element);
+
+        // Bulk insert: sorts and dedups the batch, then merges it into the
+        // container in one linear pass instead of one shifted insert per value.
+        void addElements(std::span<const T> elements);
+
+        template <typename InputIt>
+        void addElements(InputIt first, InputIt last)
+        {
+            vector<T> batch(first, last);
+            mergeBatch(batch);
+        }
+
+        // Inserts every integer in [low, high]; values already present are
+        // skipped. Primes in the interval come from PrimePolicy::classifyRange,
+        // one segmented sieve for the default policy.
+        void addRange(T low, T high);
+
+        // Replaces the contents with the distinct values of values, using up
+        // to threads threads (0 means every hardware thread): chunks are
+        // sorted in parallel and merged pairwise in parallel rounds, then the
+        // deduplicated array is classified chunk by chunk in parallel.
+        void build(std::span<const T> values, unsigned threads = 0);
+
+        void removeElement(T element);
+
+        // Non-throwing removeElement: returns false when element is missing
+        bool tryRemove(T element);
+
+        bool contains(T element) const
+        {
+            std::shared_lock<LockPolicy> guard(_lock);
+            return _elements.contains(element);
+        }
+
+        // found[i] = contains(elements[i]) for every query, under one shared
+        // lock. Contiguous storage runs the interleaved branchless search of
+        // batchContains; other storages answer one query at a time. Throws
+        // std::runtime_error when the spans differ in length.
+        void containsBatch(std::span<const T> elements, std::span<bool> found) const
         {
-            // Release memory for the int* pointers in _prime vector
-            for (auto *ptr : _prime)
+            std::shared_lock<LockPolicy> guard(_lock);
+            if constexpr (requires(const storage_type &storage) { storage.raw(); })
             {
-                delete ptr;
+                batchContains<T>(_elements.raw(), elements, found);
+            }
+            else
+            {
+                if (elements.size() != found.size())
+                {
+                    throw std::runtime_error("containsBatch needs one output per query");
+                }
+                for (size_t idx = 0; idx < elements.size(); ++idx)
+                {
+                    found[idx] = _elements.contains(elements[idx]);
+                }
             }
         }
 
-        void addElement(int element);
+        // Removes every listed value in one compaction pass and returns how
+        // many were removed; values the container does not hold are ignored.
+        size_t removeElements(std::span<const T> elements);
 
-        void removeElement(int element);
+        // Removes every element in [low, high]; both bounds are found by binary
+        // search and the span is erased at once. Returns how many were removed.
+        size_t removeRange(T low, T high);
+
+        // Removes every element matching pred in a single compaction pass and
+        // returns how many were removed
+        template <typename Predicate>
+        size_t removeIf(Predicate pred)
+        {
+            std::unique_lock<LockPolicy> guard(_lock);
+            return compactFrom(0, [&pred](const T &element)
+                               { return static_cast<bool>(pred(element)); });
+        }
 
         size_t size() const
         {
+            std::shared_lock<LockPolicy> guard(_lock);
             return _elements.size();
         }
 
-        vector<int> &getVec() { return _elements; }
-        vector<int *> &getPrime() { return _prime; }
+        const storage_type &getStorage() const { return _elements; }
+
+        // Ranks of the prime elements in ascending order, read out of the
+        // storage's prime tags
+        vector<uint32_t> getPrime() const
+        {
+            std::shared_lock<LockPolicy> guard(_lock);
+            vector<uint32_t> ranks(_elements.primeCount());
+            for (size_t k = 0; k < ranks.size(); ++k)
+            {
+                ranks[k] = static_cast<uint32_t>(_elements.primeRank(k));
+            }
+            return ranks;
+        }
+
+        PrimePolicy &getPrimality() { return _primality; }
+
+        // The flat element vector, for contiguous storage only. Read-only:
+        // the storage keeps its prime index in step with the values.
+        const vector<T> &getVec() const
+            requires requires(const storage_type &storage) { storage.raw(); }
+        {
+            return _elements.raw();
+        }
+
+        // The sieve cache of the default primality policy
+        PrimeSieveCache &getSieve()
+            requires requires(PrimePolicy &policy) { policy.sieve(); }
+        {
+            return _primality.sieve();
+        }
+
+        static bool isPrime(T number) { return PrimePolicy::isPrime(number); }
 
-        static bool isPrime(int number);
+        // Element at each traversal position, one struct per order. at also
+        // takes an Order::Cursor that iterators keep between steps, so each
+        // step reuses where the storage found the previous element (on
+        // blocked storage, the block) instead of searching from the top.
+        struct AscendingOrder
+        {
+            using Cursor = typename storage_type::Cursor;
 
+            static size_t length(const BasicMagicalContainer &container) { return container._elements.size(); }
+            static T at(const BasicMagicalContainer &container, size_t pos, Cursor &cursor) { return container._elements.at(pos, cursor); }
+            static T at(const BasicMagicalContainer &container, size_t pos)
+            {
+                Cursor cursor;
+                return at(container, pos, cursor);
+            }
+            static size_t lowerBound(const BasicMagicalContainer &container, T value) { return container._elements.lowerBound(value); }
+            static size_t upperBound(const BasicMagicalContainer &container, T value) { return container._elements.upperBound(value); }
+            static size_t seek(const BasicMagicalContainer &container, T value) { return lowerBound(container, value); }
+        };
+
+        struct SideCrossOrder
+        {
+            // One storage cursor per side, each moving one element per two steps
+            struct Cursor
+            {
+                typename storage_type::Cursor front;
+                typename storage_type::Cursor back;
+            };
+
+            static size_t length(const BasicMagicalContainer &container) { return container._elements.size(); }
+            // Even positions walk up from the front, odd positions walk down from the back
+            static T at(const BasicMagicalContainer &container, size_t pos, Cursor &cursor)
+            {
+                return (pos % 2 == 0) ? container._elements.at(pos / 2, cursor.front)
+                                      : container._elements.at(container._elements.size() - 1 - pos / 2, cursor.back);
+            }
+
+            static T at(const BasicMagicalContainer &container, size_t pos)
+            {
+                Cursor cursor;
+                return at(container, pos, cursor);
+            }
+
+            // Position of the first element >= value: rank r is visited from
+            // the front at 2r in the lower half and from the back at
+            // 2(n - 1 - r) + 1 in the upper half
+            static size_t seek(const BasicMagicalContainer &container, T value)
+            {
+                size_t count = container._elements.size();
+                size_t rank = container._elements.lowerBound(value);
+                if (rank == count)
+                {
+                    return count;
+                }
+                return rank < (count + 1) / 2 ? 2 * rank : 2 * (count - 1 - rank) + 1;
+            }
+        };
+
+        struct PrimeOrder
+        {
+            using Cursor = typename storage_type::Cursor;
+
+            static size_t length(const BasicMagicalContainer &container) { return container._elements.primeCount(); }
+            static T at(const BasicMagicalContainer &container, size_t pos, Cursor &cursor) { return container._elements.primeAt(pos, cursor); }
+            static T at(const BasicMagicalContainer &container, size_t pos) { return container._elements.primeAt(pos); }
+
+            // The element rank of the bound, then the first prime at or after that rank
+            static size_t lowerBound(const BasicMagicalContainer &container, T value) { return firstPrimeFrom(container, container._elements.lowerBound(value)); }
+            static size_t upperBound(const BasicMagicalContainer &container, T value) { return firstPrimeFrom(container, container._elements.upperBound(value)); }
+            static size_t seek(const BasicMagicalContainer &container, T value) { return lowerBound(container, value); }
+
+            static size_t firstPrimeFrom(const BasicMagicalContainer &container, size_t rank) { return container._elements.primesBefore(rank); }
+        };
+
+        template <typename Order>
+        using view = MagicalView<BasicMagicalContainer, Order>;
+
+        using AscendingView = view<AscendingOrder>;
+        using SideCrossView = view<SideCrossOrder>;
+        using PrimeView = view<PrimeOrder>;
+
+        AscendingView ascending() const { return AscendingView(*this); }
+        SideCrossView sideCross() const { return SideCrossView(*this); }
+        PrimeView primes() const { return PrimeView(*this); }
+
+        // Shared state, comparisons and jumps of the three iterators. Each
+        // iterator passes itself as Derived, so comparing iterators of
+        // different kinds does not compile and every call below is resolved
+        // statically. Comparisons and jumps work on the traversal position,
+        // which Derived maps to and from its index and side. Checks is the
+        // iteration policy (MagicalPolicies.hpp) that handles range checks.
+        template <typename Derived, typename Order, typename Checks>
         class iterator
         {
         private:
-            MagicalContainer &_container;
+            BasicMagicalContainer &_container;
             size_t _index;
-            bool _beginSide; // True for begin() side, False for end() side
+            bool _beginSide;                         // True for begin() side, False for end() side
+            mutable typename Order::Cursor _cursor{}; // Where the last dereference landed in the storage
+
+            const Derived &self() const { return static_cast<const Derived &>(*this); }
+            Derived &self() { return static_cast<Derived &>(*this); }
 
         public:
-            iterator(MagicalContainer &container) : _container(container), _index(0), _beginSide(true) {}
-            iterator(iterator &other) : _container(other.getContainer()), _index(other.getIndex()), _beginSide(other.getBeginSide()) {}
-            virtual ~iterator() = default;
+            // Input iterators to the standard library, like the views' ones:
+            // jumps and differences are O(1), but the container reference
+            // rules out the default constructor a forward iterator needs.
+            // Elements are computed on dereference and returned by value, so
+            // reference is T and there is no pointer type.
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = void;
+            using reference = T;
+
+            iterator(BasicMagicalContainer &container) : _container(container), _index(0), _beginSide(true) {}
+            iterator(const iterator &other) = default;
+            ~iterator() = default;
             // Disable move constructor
             iterator(iterator &&) = delete;
 
             // Disable move assignment operator
             iterator &operator=(iterator &&) = delete;
 
-            MagicalContainer &getContainer() { return _container; }
+            BasicMagicalContainer &getContainer() const { return _container; }
             size_t getIndex() const { return _index; }
             bool getBeginSide() const { return _beginSide; }
 
             void setIndex(size_t idx) { _index = idx; }
             void setBeginSide(bool boolean) { _beginSide = boolean; }
 
-            bool operator==(const iterator &other) const;
+            // Ascending and prime order keep the position in the index
+            size_t position() const { return getIndex(); }
+            void setPosition(size_t pos) { setIndex(pos); }
+
+            T operator*() const
+            {
+                return Order::at(getContainer(), self().position(), _cursor);
+            }
+
+            T operator[](ptrdiff_t steps) const
+            {
+                return Order::at(getContainer(), checkedPosition(steps, false), _cursor);
+            }
 
-            iterator &operator=(const iterator &other);
+            Derived &operator+=(ptrdiff_t steps)
+            {
+                self().setPosition(checkedPosition(steps, true));
+                return self();
+            }
 
-            bool operator!=(const iterator &other) const;
+            Derived &operator-=(ptrdiff_t steps)
+            {
+                return *this += -steps;
+            }
 
-            bool operator>(const iterator &other) const;
+            Derived &operator--()
+            {
+                return *this -= 1;
+            }
 
-            bool operator<(const iterator &other) const;
+            // Each iterator declares its own prefix ++, which would hide a
+            // member postfix one, so this is a friend found through the base
+            friend Derived operator++(Derived &it, int)
+            {
+                Derived old(it);
+                ++it;
+                return old;
+            }
 
-            virtual int operator*() = 0;
+            // Moves to the position of the first element >= value in
+            // O(log n), or to end() when there is none
+            Derived &seek(T value)
+            {
+                self().setPosition(Order::seek(getContainer(), value));
+                return self();
+            }
 
-            virtual iterator &operator++() = 0;
+            ptrdiff_t operator-(const Derived &other) const
+            {
+                return static_cast<ptrdiff_t>(self().position()) - static_cast<ptrdiff_t>(other.position());
+            }
 
-            virtual iterator &begin() = 0;
+            bool operator==(const Derived &other) const
+            {
+                return self().position() == other.position();
+            }
 
-            virtual iterator &end() = 0;
+            iterator &operator=(const iterator &other)
+            {
+                if (&_container != &other._container)
+                {
+                    throw std::runtime_error("Incompatible iterator types");
+                }
+                setIndex(other.getIndex());
+                setBeginSide(other.getBeginSide());
+                return *this;
+            }
+
+            bool operator!=(const Derived &other) const
+            {
+                return !(*this == other);
+            }
+
+            bool operator>(const Derived &other) const
+            {
+                return self().position() > other.position();
+            }
+
+            bool operator<(const Derived &other) const
+            {
+                return self().position() < other.position();
+            }
+
+        protected:
+            static void checkRange(bool inRange, const char *message) { Checks::check(inRange, message); }
+
+        private:
+            // Position steps away from this one; end() is allowed only as a jump target
+            size_t checkedPosition(ptrdiff_t steps, bool allowEnd) const
+            {
+                auto target = static_cast<ptrdiff_t>(self().position()) + steps;
+                auto length = static_cast<ptrdiff_t>(Order::length(getContainer()));
+                checkRange(target >= 0 && target <= length && (target < length || allowEnd), "iterator jump out of range");
+                return static_cast<size_t>(target);
+            }
         };
 
-        class AscendingIterator : public iterator
+        template <typename Checks>
+        class BasicAscendingIterator : public iterator<BasicAscendingIterator<Checks>, AscendingOrder, Checks>
         {
-        public:
-            AscendingIterator(MagicalContainer &container) : iterator(container) {}
+            using base = iterator<BasicAscendingIterator<Checks>, AscendingOrder, Checks>;
 
-            int operator*() override;
+        public:
+            BasicAscendingIterator(BasicMagicalContainer &container) : base(container) {}
 
-            AscendingIterator &operator++() override;
+            BasicAscendingIterator &operator++()
+            {
+                base::checkRange(this->getIndex() != this->getContainer().size(), "iterator at the end-1");
+                this->setIndex(this->getIndex() + 1);
+                return *this;
+            }
 
-            AscendingIterator &begin() override;
+            BasicAscendingIterator &begin()
+            {
+                this->setIndex(0);
+                return *this;
+            }
 
-            AscendingIterator &end() override;
+            BasicAscendingIterator &end()
+            {
+                this->setIndex(AscendingOrder::length(this->getContainer()));
+                return *this;
+            }
         };
 
-        class SideCrossIterator : public iterator
+        template <typename Checks>
+        class BasicSideCrossIterator : public iterator<BasicSideCrossIterator<Checks>, SideCrossOrder, Checks>
         {
+            using base = iterator<BasicSideCrossIterator<Checks>, SideCrossOrder, Checks>;
+
         public:
-            SideCrossIterator(MagicalContainer &container) : iterator(container) {}
+            BasicSideCrossIterator(BasicMagicalContainer &container) : base(container) {}
 
-            int operator*() override;
+            // Front index i is position 2i, back index i is position 2i + 1
+            // and end() is position size()
+            size_t position() const
+            {
+                return this->getIndex() == this->getContainer().size() ? this->getIndex() : 2 * this->getIndex() + (this->getBeginSide() ? 0 : 1);
+            }
 
-            SideCrossIterator &operator++() override;
+            void setPosition(size_t pos)
+            {
+                if (pos >= this->getContainer().size())
+                {
+                    end();
+                    return;
+                }
+                this->setIndex(pos / 2);
+                this->setBeginSide(pos % 2 == 0);
+            }
+
+            BasicSideCrossIterator &operator++()
+            {
+                base::checkRange(this->getIndex() != this->getContainer().size(), "iterator at the end-2");
+                setPosition(position() + 1);
+                return *this;
+            }
 
-            SideCrossIterator &begin() override;
+            BasicSideCrossIterator &begin()
+            {
+                setPosition(0);
+                return *this;
+            }
 
-            SideCrossIterator &end() override;
+            BasicSideCrossIterator &end()
+            {
+                this->setIndex(this->getContainer().size());
+                this->setBeginSide(false);
+                return *this;
+            }
         };
 
-        class PrimeIterator : public iterator
+        template <typename Checks>
+        class BasicPrimeIterator : public iterator<BasicPrimeIterator<Checks>, PrimeOrder, Checks>
         {
-        public:
-            PrimeIterator(MagicalContainer &container) : iterator(container) {}
+            using base = iterator<BasicPrimeIterator<Checks>, PrimeOrder, Checks>;
 
-            int operator*() override;
+        public:
+            BasicPrimeIterator(BasicMagicalContainer &container) : base(container) {}
 
-            PrimeIterator &operator++() override;
+            BasicPrimeIterator &operator++()
+            {
+                base::checkRange(this->getIndex() != PrimeOrder::length(this->getContainer()), "increment beyond the end");
+                this->setIndex(this->getIndex() + 1);
+                return *this;
+            }
 
-            PrimeIterator &begin() override;
+            BasicPrimeIterator &begin()
+            {
+                this->setIndex(0);
+                return *this;
+            }
 
-            PrimeIterator &end() override;
+            BasicPrimeIterator &end()
+            {
+                this->setIndex(PrimeOrder::length(this->getContainer()));
+                return *this;
+            }
         };
+
+        // The classic iterators throw std::runtime_error on out-of-range
+        // steps; the unchecked ones only assert, for hot loops that already
+        // stay in range
+        using AscendingIterator = BasicAscendingIterator<CheckedIteration>;
+        using SideCrossIterator = BasicSideCrossIterator<CheckedIteration>;
+        using PrimeIterator = BasicPrimeIterator<CheckedIteration>;
+        using UncheckedAscendingIterator = BasicAscendingIterator<UncheckedIteration>;
+        using UncheckedSideCrossIterator = BasicSideCrossIterator<UncheckedIteration>;
+        using UncheckedPrimeIterator = BasicPrimeIterator<UncheckedIteration>;
     };
+
+    ////////// BasicMagicalContainer members //////////
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    void BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::addElement(T element)
+    {
+        std::unique_lock<LockPolicy> guard(_lock);
+        size_t rank = _elements.lowerBound(element);
+        if (rank < _elements.size() && _elements[rank] == element)
+        {
+            return;
+        }
+
+        _elements.insertAt(rank, element, _primality.isPrimeCached(element));
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    template <typename ValueAt, typename PrimeAt>
+    void BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::mergeRun(size_t count, ValueAt valueAt, PrimeAt primeAt)
+    {
+        vector<T> merged;
+        vector<uint8_t> mergedPrime;
+        merged.reserve(_elements.size() + count);
+        mergedPrime.reserve(_elements.size() + count);
+
+        // Merge both sorted runs, carrying the prime tags of the old elements
+        // and classifying only the new ones
+        size_t runIdx = 0;
+        auto takeRun = [&]()
+        {
+            mergedPrime.push_back(static_cast<uint8_t>(primeAt(runIdx)));
+            merged.push_back(valueAt(runIdx++));
+        };
+        _elements.forEachTagged([&](const T &element, bool prime)
+                                {
+                                    while (runIdx < count && valueAt(runIdx) < element)
+                                    {
+                                        takeRun();
+                                    }
+                                    if (runIdx < count && valueAt(runIdx) == element)
+                                    {
+                                        ++runIdx;
+                                    }
+                                    mergedPrime.push_back(static_cast<uint8_t>(prime));
+                                    merged.push_back(element); });
+        while (runIdx < count)
+        {
+            takeRun();
+        }
+        _elements.assign(std::move(merged), mergedPrime);
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    void BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::addElements(std::span<const T> elements)
+    {
+        vector<T> batch(elements.begin(), elements.end());
+        mergeBatch(batch);
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    void BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::mergeBatch(vector<T> &batch)
+    {
+        sortUnique(batch);
+
+        std::unique_lock<LockPolicy> guard(_lock);
+        // Keep only the values the container does not hold yet
+        vector<T> fresh;
+        fresh.reserve(batch.size());
+        std::set_difference(batch.begin(), batch.end(), _elements.begin(), _elements.end(), std::back_inserter(fresh));
+        if (fresh.empty())
+        {
+            return;
+        }
+
+        vector<uint8_t> freshPrime(fresh.size());
+        PrimePolicy::template classify<T>(fresh, freshPrime);
+
+        mergeRun(
+            fresh.size(), [&fresh](size_t idx)
+            { return fresh[idx]; },
+            [&freshPrime](size_t idx)
+            { return freshPrime[idx] != 0; });
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    void BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::addRange(T low, T high)
+    {
+        if (low > high)
+        {
+            return;
+        }
+
+        // Unsigned arithmetic keeps the width exact even across the whole range of T
+        auto count = static_cast<size_t>(static_cast<uint64_t>(high) - static_cast<uint64_t>(low)) + 1;
+        vector<uint8_t> rangePrime(count);
+        PrimePolicy::template classifyRange<T>(low, high, rangePrime);
+
+        std::unique_lock<LockPolicy> guard(_lock);
+        mergeRun(
+            count, [low](size_t idx)
+            { return static_cast<T>(static_cast<uint64_t>(low) + idx); },
+            [&rangePrime](size_t idx)
+            { return rangePrime[idx] != 0; });
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    void BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::build(std::span<const T> values, unsigned threads)
+    {
+        vector<T> sorted(values.begin(), values.end());
+        vector<size_t> runs = parallelChunks(sorted.size(), threads, [&sorted](size_t first, size_t last, size_t)
+                                             { std::sort(sorted.begin() + static_cast<ptrdiff_t>(first), sorted.begin() + static_cast<ptrdiff_t>(last)); });
+
+        // Each round merges neighbouring runs two by two, one pair per thread
+        vector<T> buffer(sorted.size());
+        while (runs.size() > 2)
+        {
+            size_t runCount = runs.size() - 1;
+            size_t pairs = (runCount + 1) / 2;
+            parallelChunks(pairs, static_cast<unsigned>(pairs), [&](size_t firstPair, size_t lastPair, size_t)
+                           {
+                               for (size_t pair = firstPair; pair < lastPair; ++pair)
+                               {
+                                   auto low = sorted.begin() + static_cast<ptrdiff_t>(runs[2 * pair]);
+                                   auto mid = sorted.begin() + static_cast<ptrdiff_t>(runs[std::min(2 * pair + 1, runCount)]);
+                                   auto high = sorted.begin() + static_cast<ptrdiff_t>(runs[std::min(2 * pair + 2, runCount)]);
+                                   std::merge(low, mid, mid, high, buffer.begin() + static_cast<ptrdiff_t>(runs[2 * pair]));
+                               } });
+            vector<size_t> mergedRuns;
+            for (size_t run = 0; run < runCount; run += 2)
+            {
+                mergedRuns.push_back(runs[run]);
+            }
+            mergedRuns.push_back(runs.back());
+            runs.swap(mergedRuns);
+            sorted.swap(buffer);
+        }
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+        vector<uint8_t> isPrimeAt(sorted.size());
+        parallelChunks(sorted.size(), threads, [&](size_t first, size_t last, size_t)
+                       { PrimePolicy::template classify<T>(std::span<const T>(sorted).subspan(first, last - first),
+                                                           std::span<uint8_t>(isPrimeAt).subspan(first, last - first)); });
+
+        std::unique_lock<LockPolicy> guard(_lock);
+        _elements.assign(std::move(sorted), isPrimeAt);
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    void BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::removeElement(T element)
+    {
+        if (!tryRemove(element))
+        {
+            throw std::runtime_error("Element not found");
+        }
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    bool BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::tryRemove(T element)
+    {
+        std::unique_lock<LockPolicy> guard(_lock);
+        size_t rank = _elements.lowerBound(element);
+        if (rank == _elements.size() || _elements[rank] != element)
+        {
+            return false;
+        }
+        _elements.eraseAt(rank);
+        return true;
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    size_t BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::removeElements(std::span<const T> elements)
+    {
+        vector<T> batch(elements.begin(), elements.end());
+        sortUnique(batch);
+
+        if (batch.empty())
+        {
+            return 0;
+        }
+
+        // Start at the first element that can go; the batch cursor only moves forward
+        std::unique_lock<LockPolicy> guard(_lock);
+        size_t first = _elements.lowerBound(batch.front());
+        auto batchIt = batch.begin();
+        return compactFrom(first, [&batchIt, &batch](const T &element)
+                           {
+                               while (batchIt != batch.end() && *batchIt < element)
+                               {
+                                   ++batchIt;
+                               }
+                               return batchIt != batch.end() && *batchIt == element; });
+    }
+
+    template <typename T, typename Storage, typename PrimePolicy, typename LockPolicy>
+    size_t BasicMagicalContainer<T, Storage, PrimePolicy, LockPolicy>::removeRange(T low, T high)
+    {
+        if (low > high)
+        {
+            return 0;
+        }
+        std::unique_lock<LockPolicy> guard(_lock);
+        size_t firstPos = _elements.lowerBound(low);
+        size_t lastPos = _elements.upperBound(high);
+        _elements.eraseRange(firstPos, lastPos);
+        return lastPos - firstPos;
+    }
+
+    // The all-defaults container and its 64-bit sibling; both are
+    // instantiated once in MagicalContainer.cpp
+    using MagicalContainer = BasicMagicalContainer<>;
+    using MagicalContainer64 = BasicMagicalContainer<int64_t>;
+    extern template class BasicMagicalContainer<>;
+    extern template class BasicMagicalContainer<int64_t>;
 }
-#endif
\ No newline at end of file
+
+// View iterators point at the container, not at the view, so they stay
+// valid after a temporary view is gone
+template <typename Container, typename Order>
+inline constexpr bool std::ranges::enable_borrowed_range<ariel::MagicalView<Container, Order>> = true;
+#endif
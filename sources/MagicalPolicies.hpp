@@ -0,0 +1,242 @@
+#ifndef MAGICALPOLICIES_HPP
+#define MAGICALPOLICIES_HPP
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "BlockedSortedStorage.hpp"
+#include "IndexedSortedStorage.hpp"
+#include "Primality.hpp"
+#include "PrimeSieve.hpp"
+#include "SortedVectorStorage.hpp"
+
+namespace ariel
+{
+    ////////// Storage policies //////////
+    // A storage policy names the sorted-set type that holds the elements.
+    // Each one offers ranks, lowerBound/upperBound, rank-based insert and
+    // erase, retainFrom and assign, which is all the container uses. The
+    // storage also keeps the prime tag of every element (primeCount,
+    // primeAt, primesBefore), so tags move with their elements.
+
+    // One flat sorted vector (the default)
+    struct VectorStorage
+    {
+        template <typename T>
+        using type = SortedVectorStorage<T>;
+    };
+
+    // Blocks of at most BlockSize elements; inserts and erases shift one block
+    template <size_t BlockSize = 1024>
+    struct BlockedStorage
+    {
+        template <typename T>
+        using type = BlockedSortedStorage<T, BlockSize>;
+    };
+
+    // A flat sorted vector plus a lazily rebuilt search tree for lookups,
+    // for large read-mostly sets; sets below MinSize skip the tree
+    template <size_t MinSize = 4096>
+    struct IndexedStorage
+    {
+        template <typename T>
+        using type = IndexedSortedStorage<T, MinSize>;
+    };
+
+    ////////// Primality policies //////////
+    // A primality policy answers isPrime for single values (static, and a
+    // member form that may use per-container caches), classify for a batch
+    // and classifyRange for the consecutive values of an interval.
+
+    // Wheel screen plus deterministic Miller-Rabin, with a sieve cache behind
+    // addElement and a segmented sieve behind addRange (the default). Values
+    // above 32 bits run the 64-bit Montgomery test and skip the sieves.
+    class MillerRabinPrimality
+    {
+        PrimeSieveCache _sieve;
+
+        template <typename T>
+        static constexpr bool fits32 = sizeof(T) <= sizeof(uint32_t);
+
+        // One wheel-30 sieve over the non-negative part of [low, high]; high < 2^32
+        static void sieveRange(int64_t low, int64_t high, std::span<uint8_t> out)
+        {
+            std::fill(out.begin(), out.end(), 0U);
+            if (high < 2)
+            {
+                return;
+            }
+            auto first = static_cast<uint32_t>(std::max<int64_t>(low, 0));
+            uint32_t sieveFirst = first - first % 30;
+            std::vector<uint8_t> wheel((static_cast<uint32_t>(high) - sieveFirst) / 30 + 1);
+            PrimeSieveCache::sieveWheel30(sieveFirst, wheel);
+            for (int64_t value = std::max<int64_t>(low, 2); value <= high; ++value)
+            {
+                bool verdict = false;
+                PrimeSieveCache::lookupWheel30(sieveFirst, wheel, static_cast<uint32_t>(value), verdict);
+                out[static_cast<size_t>(value - low)] = verdict ? 1U : 0U;
+            }
+        }
+
+    public:
+        template <typename T>
+        static bool isPrime(T number)
+        {
+            if (number < T{2})
+            {
+                return false;
+            }
+            if constexpr (fits32<T>)
+            {
+                return isPrime32(static_cast<uint32_t>(number));
+            }
+            else
+            {
+                return isPrime64(static_cast<uint64_t>(number));
+            }
+        }
+
+        template <typename T>
+        bool isPrimeCached(T number)
+        {
+            if (number < T{2})
+            {
+                return false;
+            }
+            if constexpr (!fits32<T>)
+            {
+                if (static_cast<uint64_t>(number) > UINT32_MAX)
+                {
+                    return isPrime64(static_cast<uint64_t>(number));
+                }
+            }
+            return _sieve.isPrime(static_cast<uint32_t>(number));
+        }
+
+        template <typename T>
+        static void classify(std::span<const T> numbers, std::span<uint8_t> out)
+        {
+            if constexpr (std::is_same_v<T, int>)
+            {
+                isPrimeBatch(numbers, out);
+            }
+            else
+            {
+                for (size_t idx = 0; idx < numbers.size(); ++idx)
+                {
+                    out[idx] = isPrime(numbers[idx]) ? 1U : 0U;
+                }
+            }
+        }
+
+        // out[k] tells whether low + k is prime; out must hold high - low + 1 entries
+        template <typename T>
+        static void classifyRange(T low, T high, std::span<uint8_t> out)
+        {
+            if constexpr (!fits32<T>)
+            {
+                if (high > T{0} && static_cast<uint64_t>(high) > UINT32_MAX)
+                {
+                    for (size_t idx = 0; idx < out.size(); ++idx)
+                    {
+                        out[idx] = isPrime(static_cast<T>(low + static_cast<T>(idx))) ? 1U : 0U;
+                    }
+                    return;
+                }
+            }
+            sieveRange(static_cast<int64_t>(low), static_cast<int64_t>(high), out);
+        }
+
+        PrimeSieveCache &sieve() { return _sieve; }
+    };
+
+    // Trial division only, without caches; the simple reference engine
+    struct TrialDivisionPrimality
+    {
+        template <typename T>
+        static bool isPrime(T number)
+        {
+            return number >= T{2} && isPrimeTrialDivision(static_cast<uint64_t>(number));
+        }
+
+        template <typename T>
+        bool isPrimeCached(T number) const { return isPrime(number); }
+
+        template <typename T>
+        static void classify(std::span<const T> numbers, std::span<uint8_t> out)
+        {
+            for (size_t idx = 0; idx < numbers.size(); ++idx)
+            {
+                out[idx] = isPrime(numbers[idx]) ? 1U : 0U;
+            }
+        }
+
+        template <typename T>
+        static void classifyRange(T low, T /*high*/, std::span<uint8_t> out)
+        {
+            for (size_t idx = 0; idx < out.size(); ++idx)
+            {
+                out[idx] = isPrime(static_cast<T>(low + static_cast<T>(idx))) ? 1U : 0U;
+            }
+        }
+    };
+
+    ////////// Lock policies //////////
+    // The container takes a unique lock around every mutation and a shared
+    // lock around size() and contains(). Iterators and views do not lock.
+
+    // No synchronisation; every call compiles away (the default)
+    struct NoLock
+    {
+        void lock() {}
+        void unlock() {}
+        void lock_shared() {}
+        void unlock_shared() {}
+    };
+
+    // A reader-writer mutex: concurrent lookups, exclusive mutations
+    class SharedMutexLock
+    {
+        std::shared_mutex _mutex;
+
+    public:
+        void lock() { _mutex.lock(); }
+        void unlock() { _mutex.unlock(); }
+        void lock_shared() { _mutex.lock_shared(); }
+        void unlock_shared() { _mutex.unlock_shared(); }
+    };
+
+    ////////// Iteration policies //////////
+    // What the classic iterators do when an increment or jump would leave
+    // the traversal. The policy is a template argument of the iterator, so
+    // checked and unchecked iterators are separate types and both can be
+    // used in one program.
+
+    // Throws std::runtime_error (the default)
+    struct CheckedIteration
+    {
+        static void check(bool inRange, const char *message)
+        {
+            if (!inRange)
+            {
+                throw std::runtime_error(message);
+            }
+        }
+    };
+
+    // A debug-only assertion, which NDEBUG compiles away
+    struct UncheckedIteration
+    {
+        static void check([[maybe_unused]] bool inRange, [[maybe_unused]] const char *message)
+        {
+            assert(inRange && message);
+        }
+    };
+}
+#endif
@@ -0,0 +1,68 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace ariel
+{
+    // Thread count to use when the caller passes 0: every hardware thread
+    inline unsigned resolveThreads(unsigned threads)
+    {
+        if (threads == 0)
+        {
+            threads = std::thread::hardware_concurrency();
+        }
+        return threads == 0 ? 1 : threads;
+    }
+
+    // Splits [0, count) into at most threads contiguous chunks of near-equal
+    // size and runs fn(first, last, chunk) for each, the first chunk on the
+    // calling thread. Returns the chunk boundaries (chunks + 1 entries).
+    // Exceptions from any chunk are rethrown after all chunks finish.
+    template <typename Fn>
+    std::vector<size_t> parallelChunks(size_t count, unsigned threads, Fn fn)
+    {
+        size_t chunks = std::max<size_t>(1, std::min<size_t>(resolveThreads(threads), count));
+        std::vector<size_t> bounds(chunks + 1);
+        for (size_t chunk = 0; chunk <= chunks; ++chunk)
+        {
+            bounds[chunk] = count * chunk / chunks;
+        }
+
+        std::vector<std::exception_ptr> errors(chunks);
+        auto run = [&](size_t chunk)
+        {
+            try
+            {
+                fn(bounds[chunk], bounds[chunk + 1], chunk);
+            }
+            catch (...)
+            {
+                errors[chunk] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        for (size_t chunk = 1; chunk < chunks; ++chunk)
+        {
+            workers.emplace_back(run, chunk);
+        }
+        run(0);
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        for (std::exception_ptr &error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+        return bounds;
+    }
+}
+#endif
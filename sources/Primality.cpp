@@ -0,0 +1,392 @@
+#include "Primality.hpp"
+#include "CpuFeatures.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace ariel
+{
+    namespace
+    {
+        // Bit i is set when i is a prime below 64
+        constexpr uint64_t SMALL_PRIME_MASK = 0x28208a20a08a28acULL;
+
+        constexpr uint32_t TRIAL_PRIMES[] = {7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+        // Anything that survives trial division up to 37 and is below 41^2 is prime
+        constexpr uint32_t TRIAL_LIMIT = 41 * 41;
+
+        constexpr uint32_t MILLER_RABIN_BASES[] = {2, 7, 61};
+
+        // Sinclair's bases: no strong pseudoprime to all seven below 2^64
+        constexpr uint64_t MILLER_RABIN_BASES_64[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+        // Residues modulo 30 that are coprime to 2, 3 and 5
+        constexpr uint32_t WHEEL_MASK = (1U << 1) | (1U << 7) | (1U << 11) | (1U << 13) |
+                                        (1U << 17) | (1U << 19) | (1U << 23) | (1U << 29);
+
+        enum class Screen
+        {
+            COMPOSITE,
+            PRIME,
+            UNDECIDED // Only Miller-Rabin can settle it
+        };
+
+        Screen screen(uint32_t number)
+        {
+            if (number < 64)
+            {
+                return ((SMALL_PRIME_MASK >> number) & 1U) != 0 ? Screen::PRIME : Screen::COMPOSITE;
+            }
+            if (((WHEEL_MASK >> (number % 30)) & 1U) == 0)
+            {
+                return Screen::COMPOSITE;
+            }
+            for (uint32_t prime : TRIAL_PRIMES)
+            {
+                if (number % prime == 0)
+                {
+                    return Screen::COMPOSITE;
+                }
+            }
+            return number < TRIAL_LIMIT ? Screen::PRIME : Screen::UNDECIDED;
+        }
+
+        // Montgomery arithmetic modulo an odd 32-bit number with R = 2^32
+        struct Montgomery32
+        {
+            uint32_t modulus;
+            uint32_t inverse; // modulus^-1 mod 2^32
+            uint32_t one;     // R mod modulus
+            uint32_t minusOne;
+            uint32_t rSquared; // R^2 mod modulus, converts values into Montgomery form
+
+            explicit Montgomery32(uint32_t odd)
+                : modulus(odd), inverse(odd), one(static_cast<uint32_t>((uint64_t{1} << 32U) % odd)), minusOne(odd - one),
+                  rSquared(static_cast<uint32_t>(uint64_t{one} * one % odd))
+            {
+                // Newton's iteration doubles the number of correct low bits each step
+                for (int i = 0; i < 4; ++i)
+                {
+                    inverse *= 2 - odd * inverse;
+                }
+            }
+
+            uint32_t toForm(uint32_t value) const
+            {
+                return mul(value, rSquared);
+            }
+
+            uint32_t mul(uint32_t lhs, uint32_t rhs) const
+            {
+                uint64_t product = uint64_t{lhs} * rhs;
+                uint32_t factor = static_cast<uint32_t>(product) * inverse;
+                auto high = static_cast<uint32_t>(product >> 32U);
+                auto correction = static_cast<uint32_t>((uint64_t{factor} * modulus) >> 32U);
+                return high >= correction ? high - correction : high - correction + modulus;
+            }
+        };
+
+        struct OddSplit
+        {
+            uint32_t oddPart; // number - 1 == oddPart * 2^twos
+            unsigned twos;
+        };
+
+        OddSplit splitOdd(uint32_t number)
+        {
+            OddSplit split{number - 1, 0};
+            while ((split.oddPart & 1U) == 0)
+            {
+                split.oddPart >>= 1U;
+                ++split.twos;
+            }
+            return split;
+        }
+
+        bool millerRabin(uint32_t number)
+        {
+            Montgomery32 mont(number);
+            OddSplit split = splitOdd(number);
+            for (uint32_t base : MILLER_RABIN_BASES)
+            {
+                uint32_t value = mont.one;
+                uint32_t power = mont.toForm(base);
+                for (uint32_t exponent = split.oddPart; exponent > 0; exponent >>= 1U)
+                {
+                    if ((exponent & 1U) != 0)
+                    {
+                        value = mont.mul(value, power);
+                    }
+                    power = mont.mul(power, power);
+                }
+                bool witnessPasses = value == mont.one || value == mont.minusOne;
+                for (unsigned i = 1; i < split.twos && !witnessPasses; ++i)
+                {
+                    value = mont.mul(value, value);
+                    witnessPasses = value == mont.minusOne;
+                }
+                if (!witnessPasses)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Montgomery arithmetic modulo an odd 64-bit number with R = 2^64;
+        // products go through unsigned __int128
+        struct Montgomery64
+        {
+            uint64_t modulus;
+            uint64_t inverse; // modulus^-1 mod 2^64
+            uint64_t one;     // R mod modulus
+            uint64_t minusOne;
+            uint64_t rSquared; // R^2 mod modulus, converts values into Montgomery form
+
+            explicit Montgomery64(uint64_t odd)
+                : modulus(odd), inverse(odd), one((0 - odd) % odd), minusOne(odd - one),
+                  rSquared(static_cast<uint64_t>(static_cast<unsigned __int128>(one) * one % odd))
+            {
+                for (int i = 0; i < 5; ++i)
+                {
+                    inverse *= 2 - odd * inverse;
+                }
+            }
+
+            uint64_t toForm(uint64_t value) const
+            {
+                return mul(value % modulus, rSquared);
+            }
+
+            uint64_t mul(uint64_t lhs, uint64_t rhs) const
+            {
+                auto product = static_cast<unsigned __int128>(lhs) * rhs;
+                uint64_t factor = static_cast<uint64_t>(product) * inverse;
+                auto high = static_cast<uint64_t>(product >> 64U);
+                auto correction = static_cast<uint64_t>((static_cast<unsigned __int128>(factor) * modulus) >> 64U);
+                return high >= correction ? high - correction : high - correction + modulus;
+            }
+        };
+
+        bool millerRabin64(uint64_t number)
+        {
+            Montgomery64 mont(number);
+            uint64_t oddPart = number - 1;
+            unsigned twos = 0;
+            while ((oddPart & 1U) == 0)
+            {
+                oddPart >>= 1U;
+                ++twos;
+            }
+            for (uint64_t base : MILLER_RABIN_BASES_64)
+            {
+                uint64_t power = mont.toForm(base);
+                if (power == 0)
+                {
+                    continue; // base is a multiple of number and proves nothing
+                }
+                uint64_t value = mont.one;
+                for (uint64_t exponent = oddPart; exponent > 0; exponent >>= 1U)
+                {
+                    if ((exponent & 1U) != 0)
+                    {
+                        value = mont.mul(value, power);
+                    }
+                    power = mont.mul(power, power);
+                }
+                bool witnessPasses = value == mont.one || value == mont.minusOne;
+                for (unsigned i = 1; i < twos && !witnessPasses; ++i)
+                {
+                    value = mont.mul(value, value);
+                    witnessPasses = value == mont.minusOne;
+                }
+                if (!witnessPasses)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+#ifdef MAGICAL_HAVE_AVX2
+        // Four Montgomery products at once; each 64-bit lane holds one 32-bit value
+        __attribute__((target("avx2"))) __m256i montMul4(__m256i lhs, __m256i rhs, __m256i modulus, __m256i inverse)
+        {
+            __m256i product = _mm256_mul_epu32(lhs, rhs);
+            __m256i factor = _mm256_mul_epu32(product, inverse);
+            __m256i correction = _mm256_srli_epi64(_mm256_mul_epu32(factor, modulus), 32);
+            __m256i diff = _mm256_sub_epi64(_mm256_srli_epi64(product, 32), correction);
+            __m256i negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), diff);
+            return _mm256_add_epi64(diff, _mm256_and_si256(negative, modulus));
+        }
+
+        __attribute__((target("avx2"))) __m256i loadLanes(const uint64_t *lanes)
+        {
+            return _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes));
+        }
+
+        // Runs all Miller-Rabin rounds for four candidates that passed the screen
+        __attribute__((target("avx2"))) void millerRabin4(const uint32_t *numbers, uint8_t *out)
+        {
+            alignas(32) uint64_t lanes[6][4];
+            uint32_t maxOddPart = 0;
+            unsigned maxTwos = 0;
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                Montgomery32 mont(numbers[lane]);
+                OddSplit split = splitOdd(numbers[lane]);
+                lanes[0][lane] = mont.modulus;
+                lanes[1][lane] = mont.inverse;
+                lanes[2][lane] = mont.one;
+                lanes[3][lane] = mont.minusOne;
+                lanes[4][lane] = split.oddPart | (uint64_t{split.twos} << 32U);
+                lanes[5][lane] = mont.rSquared;
+                maxOddPart = split.oddPart > maxOddPart ? split.oddPart : maxOddPart;
+                maxTwos = split.twos > maxTwos ? split.twos : maxTwos;
+            }
+            __m256i modulus = loadLanes(lanes[0]);
+            __m256i inverse = loadLanes(lanes[1]);
+            __m256i one = loadLanes(lanes[2]);
+            __m256i minusOne = loadLanes(lanes[3]);
+            __m256i oddPart = _mm256_and_si256(loadLanes(lanes[4]), _mm256_set1_epi64x(0xffffffff));
+            __m256i twos = _mm256_srli_epi64(loadLanes(lanes[4]), 32);
+            __m256i rSquared = loadLanes(lanes[5]);
+            __m256i bitOne = _mm256_set1_epi64x(1);
+
+            __m256i allPass = _mm256_set1_epi64x(-1);
+            for (uint32_t base : MILLER_RABIN_BASES)
+            {
+                __m256i power = montMul4(_mm256_set1_epi64x(base), rSquared, modulus, inverse);
+                __m256i value = one;
+                __m256i exponent = oddPart;
+                for (uint32_t remaining = maxOddPart; remaining > 0; remaining >>= 1U)
+                {
+                    __m256i bitSet = _mm256_cmpeq_epi64(_mm256_and_si256(exponent, bitOne), bitOne);
+                    value = _mm256_blendv_epi8(value, montMul4(value, power, modulus, inverse), bitSet);
+                    power = montMul4(power, power, modulus, inverse);
+                    exponent = _mm256_srli_epi64(exponent, 1);
+                }
+                __m256i pass = _mm256_or_si256(_mm256_cmpeq_epi64(value, one), _mm256_cmpeq_epi64(value, minusOne));
+                for (unsigned i = 1; i < maxTwos; ++i)
+                {
+                    value = montMul4(value, value, modulus, inverse);
+                    __m256i active = _mm256_cmpgt_epi64(twos, _mm256_set1_epi64x(i));
+                    pass = _mm256_or_si256(pass, _mm256_and_si256(active, _mm256_cmpeq_epi64(value, minusOne)));
+                }
+                allPass = _mm256_and_si256(allPass, pass);
+                if (_mm256_testz_si256(allPass, allPass) != 0)
+                {
+                    break;
+                }
+            }
+            int mask = _mm256_movemask_pd(_mm256_castsi256_pd(allPass));
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                out[lane] = static_cast<uint8_t>((static_cast<unsigned>(mask) >> static_cast<unsigned>(lane)) & 1U);
+            }
+        }
+#endif
+    }
+
+    bool isPrime32(uint32_t number)
+    {
+        Screen verdict = screen(number);
+        if (verdict != Screen::UNDECIDED)
+        {
+            return verdict == Screen::PRIME;
+        }
+        return millerRabin(number);
+    }
+
+    bool isPrime64(uint64_t number)
+    {
+        if (number <= UINT32_MAX)
+        {
+            return isPrime32(static_cast<uint32_t>(number));
+        }
+        if (((WHEEL_MASK >> (number % 30)) & 1U) == 0)
+        {
+            return false;
+        }
+        for (uint32_t prime : TRIAL_PRIMES)
+        {
+            if (number % prime == 0)
+            {
+                return false;
+            }
+        }
+        return millerRabin64(number);
+    }
+
+    bool isPrimeTrialDivision(uint64_t number)
+    {
+        if (number < 4)
+        {
+            return number >= 2;
+        }
+        if (number % 2 == 0 || number % 3 == 0)
+        {
+            return false;
+        }
+        // Candidates 6k - 1 and 6k + 1; divisor <= number / divisor avoids overflowing divisor^2
+        for (uint64_t divisor = 5; divisor <= number / divisor; divisor += 6)
+        {
+            if (number % divisor == 0 || number % (divisor + 2) == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void isPrimeBatch(std::span<const int> numbers, std::span<uint8_t> out)
+    {
+        if (numbers.size() != out.size())
+        {
+            throw std::runtime_error("isPrimeBatch: output size does not match input size");
+        }
+
+        // Settle what the cheap checks can, queue the rest for Miller-Rabin
+        std::vector<uint32_t> pending;
+        std::vector<size_t> pendingAt;
+        for (size_t i = 0; i < numbers.size(); ++i)
+        {
+            if (numbers[i] < 2)
+            {
+                out[i] = 0;
+                continue;
+            }
+            auto number = static_cast<uint32_t>(numbers[i]);
+            Screen verdict = screen(number);
+            if (verdict == Screen::UNDECIDED)
+            {
+                pending.push_back(number);
+                pendingAt.push_back(i);
+            }
+            else
+            {
+                out[i] = verdict == Screen::PRIME ? 1 : 0;
+            }
+        }
+
+        size_t done = 0;
+#ifdef MAGICAL_HAVE_AVX2
+        if (cpuHasAvx2())
+        {
+            uint8_t verdicts[4];
+            for (; done + 4 <= pending.size(); done += 4)
+            {
+                millerRabin4(&pending[done], verdicts);
+                for (size_t lane = 0; lane < 4; ++lane)
+                {
+                    out[pendingAt[done + lane]] = verdicts[lane];
+                }
+            }
+        }
+#endif
+        for (; done < pending.size(); ++done)
+        {
+            out[pendingAt[done]] = millerRabin(pending[done]) ? 1 : 0;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef PRIMALITY_HPP
+#define PRIMALITY_HPP
+#include <cstdint>
+#include <span>
+
+namespace ariel
+{
+    // Deterministic primality test for any 32-bit value: a small-prime
+    // table and wheel check, then Miller-Rabin with bases 2, 7 and 61,
+    // which has no false positives below 4,759,123,141.
+    bool isPrime32(uint32_t number);
+
+    // Deterministic primality test for any 64-bit value. Values that fit in
+    // 32 bits go to isPrime32; larger ones get the wheel and small-prime
+    // screen, then Miller-Rabin with Sinclair's seven bases in 64-bit
+    // Montgomery form.
+    bool isPrime64(uint64_t number);
+
+    // Plain trial division by 6k +- 1, O(sqrt(n)). Kept as the reference
+    // engine for TrialDivisionPrimality and for cross-checking the fast tests.
+    bool isPrimeTrialDivision(uint64_t number);
+
+    // Classifies a whole batch at once: out[i] is 1 when numbers[i] is prime
+    // and 0 otherwise (negative values are never prime). Candidates that
+    // survive the cheap checks run their Miller-Rabin rounds four at a time
+    // in AVX2 lanes when the CPU has it, and one at a time otherwise.
+    // Throws std::runtime_error when the spans differ in length.
+    void isPrimeBatch(std::span<const int> numbers, std::span<uint8_t> out);
+}
+#endif
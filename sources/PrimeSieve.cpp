@@ -0,0 +1,168 @@
+#include "PrimeSieve.hpp"
+#include "Primality.hpp"
+#include <algorithm>
+
+namespace ariel
+{
+    namespace
+    {
+        constexpr uint32_t WHEEL_RESIDUES[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+
+        // Bit of a residue modulo 30 in a wheel byte, or -1 when it shares a factor with 30
+        constexpr int8_t WHEEL_BIT[30] = {-1, 0, -1, -1, -1, -1, -1, 1, -1, -1, -1, 2, -1, 3, -1,
+                                          -1, -1, 4, -1, 5, -1, -1, -1, 6, -1, -1, -1, -1, -1, 7};
+
+        // Primes from 7 up to 2^16, enough to sieve any 32-bit range
+        const std::vector<uint32_t> &basePrimes()
+        {
+            static const std::vector<uint32_t> primes = []
+            {
+                constexpr uint32_t LIMIT = 1U << 16U;
+                std::vector<uint8_t> composite(LIMIT + 1, 0);
+                std::vector<uint32_t> found;
+                for (uint32_t i = 2; i <= LIMIT; ++i)
+                {
+                    if (composite[i] != 0)
+                    {
+                        continue;
+                    }
+                    if (i >= 7)
+                    {
+                        found.push_back(i);
+                    }
+                    for (uint32_t multiple = i * i; multiple <= LIMIT; multiple += i)
+                    {
+                        composite[multiple] = 1;
+                    }
+                }
+                return found;
+            }();
+            return primes;
+        }
+    }
+
+    void PrimeSieveCache::sieveWheel30(uint32_t first, std::vector<uint8_t> &bytes)
+    {
+        uint64_t last = uint64_t{first} + 30 * uint64_t{bytes.size()}; // exclusive
+        std::fill(bytes.begin(), bytes.end(), 0xff);
+        if (first == 0 && !bytes.empty())
+        {
+            bytes[0] &= 0xfe; // 1 is not prime
+        }
+
+        for (uint32_t prime : basePrimes())
+        {
+            uint64_t square = uint64_t{prime} * prime;
+            if (square >= last)
+            {
+                break;
+            }
+            uint64_t multiple = square >= first ? square : (uint64_t{first} + prime - 1) / prime * prime;
+            // Even multiples are never on the wheel, so step over them
+            if ((multiple & 1U) == 0)
+            {
+                multiple += prime;
+            }
+            for (; multiple < last; multiple += 2 * uint64_t{prime})
+            {
+                uint64_t offset = multiple - first;
+                int bit = WHEEL_BIT[offset % 30];
+                if (bit >= 0)
+                {
+                    bytes[offset / 30] &= static_cast<uint8_t>(~(1U << static_cast<unsigned>(bit)));
+                }
+            }
+        }
+    }
+
+    bool PrimeSieveCache::lookupWheel30(uint32_t first, const std::vector<uint8_t> &bytes, uint32_t number, bool &isPrime)
+    {
+        if (number < first || (number - first) / 30 >= bytes.size())
+        {
+            return false;
+        }
+        uint32_t offset = number - first;
+        int bit = WHEEL_BIT[offset % 30];
+        if (bit < 0)
+        {
+            isPrime = number == 2 || number == 3 || number == 5;
+        }
+        else
+        {
+            isPrime = ((bytes[offset / 30] >> static_cast<unsigned>(bit)) & 1U) != 0;
+        }
+        return true;
+    }
+
+    bool PrimeSieveCache::lookup(uint32_t number, bool &isPrime)
+    {
+        auto found = _segments.find(number / SEGMENT_SPAN);
+        if (found == _segments.end())
+        {
+            return false;
+        }
+        found->second.lastUsed = ++_clock;
+        return lookupWheel30(number - number % SEGMENT_SPAN, found->second.bits, number, isPrime);
+    }
+
+    bool PrimeSieveCache::isPrime(uint32_t number)
+    {
+        bool verdict = false;
+        if (lookup(number, verdict))
+        {
+            ++_hits;
+            return verdict;
+        }
+        ++_misses;
+
+        uint32_t segment = number / SEGMENT_SPAN;
+        if (_sieveAfterMisses > 0 && ++_segmentMisses[segment] >= _sieveAfterMisses)
+        {
+            sieveSegmentOf(number);
+        }
+        return isPrime32(number);
+    }
+
+    void PrimeSieveCache::sieveSegmentOf(uint32_t number)
+    {
+        uint32_t segment = number / SEGMENT_SPAN;
+        _segmentMisses.erase(segment);
+        if (_segments.count(segment) != 0 || _memoryCap < SEGMENT_BYTES)
+        {
+            return;
+        }
+        evictToFit(_memoryCap / SEGMENT_BYTES - 1);
+
+        Segment fresh{std::vector<uint8_t>(SEGMENT_BYTES), ++_clock};
+        sieveWheel30(segment * SEGMENT_SPAN, fresh.bits);
+        _segments.emplace(segment, std::move(fresh));
+    }
+
+    void PrimeSieveCache::setMemoryCap(size_t memoryCap)
+    {
+        _memoryCap = memoryCap;
+        evictToFit(_memoryCap / SEGMENT_BYTES);
+    }
+
+    void PrimeSieveCache::evictToFit(size_t segments)
+    {
+        while (_segments.size() > segments)
+        {
+            auto oldest = std::min_element(_segments.begin(), _segments.end(), [](const auto &lhs, const auto &rhs)
+                                           { return lhs.second.lastUsed < rhs.second.lastUsed; });
+            _segments.erase(oldest);
+        }
+    }
+
+    double PrimeSieveCache::hitRate() const
+    {
+        size_t lookups = _hits + _misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(_hits) / static_cast<double>(lookups);
+    }
+
+    void PrimeSieveCache::resetCounters()
+    {
+        _hits = 0;
+        _misses = 0;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef PRIMESIEVE_HPP
+#define PRIMESIEVE_HPP
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ariel
+{
+    // Lazily grown cache of sieved segments of the 32-bit value space.
+    // Each segment stores one byte per 30 numbers (a bit for each residue
+    // coprime to 30), so a segment of SEGMENT_BYTES bytes answers primality
+    // for SEGMENT_SPAN consecutive values. A segment is sieved once enough
+    // lookups have missed inside it, and the least recently used segments are
+    // evicted when the cache grows past its memory cap.
+    class PrimeSieveCache
+    {
+    public:
+        static constexpr uint32_t SEGMENT_BYTES = 8192;
+        static constexpr uint32_t SEGMENT_SPAN = 30 * SEGMENT_BYTES;
+        static constexpr size_t DEFAULT_MEMORY_CAP = 1 << 20;
+        static constexpr unsigned DEFAULT_SIEVE_AFTER_MISSES = 256;
+
+        explicit PrimeSieveCache(size_t memoryCap = DEFAULT_MEMORY_CAP, unsigned sieveAfterMisses = DEFAULT_SIEVE_AFTER_MISSES)
+            : _memoryCap(memoryCap), _sieveAfterMisses(sieveAfterMisses) {}
+
+        // Answers from a sieved segment when there is one, otherwise falls back
+        // to isPrime32 and counts a miss against the value's segment
+        bool isPrime(uint32_t number);
+
+        // True when number lies in a sieved segment; the verdict goes to isPrime
+        bool lookup(uint32_t number, bool &isPrime);
+
+        // Sieves the segment holding number right away, evicting if needed
+        void sieveSegmentOf(uint32_t number);
+
+        // Evicts least recently used segments until the cache fits in memoryCap
+        void setMemoryCap(size_t memoryCap);
+        void setSieveAfterMisses(unsigned misses) { _sieveAfterMisses = misses; }
+
+        size_t memoryCap() const { return _memoryCap; }
+        size_t memoryUsed() const { return _segments.size() * SEGMENT_BYTES; }
+        size_t segmentCount() const { return _segments.size(); }
+
+        size_t hits() const { return _hits; }
+        size_t misses() const { return _misses; }
+        double hitRate() const;
+        void resetCounters();
+
+        // Wheel-30 bitmap of [first, first + 30 * bytes.size()); first must be a multiple of 30
+        static void sieveWheel30(uint32_t first, std::vector<uint8_t> &bytes);
+
+        // Reads number's verdict from a bitmap built by sieveWheel30; false when it lies outside
+        static bool lookupWheel30(uint32_t first, const std::vector<uint8_t> &bytes, uint32_t number, bool &isPrime);
+
+    private:
+        struct Segment
+        {
+            std::vector<uint8_t> bits;
+            uint64_t lastUsed;
+        };
+
+        std::unordered_map<uint32_t, Segment> _segments;
+        uint64_t _clock = 0; // Ticks once per lookup, orders segments for eviction
+        std::unordered_map<uint32_t, unsigned> _segmentMisses;
+        size_t _memoryCap;
+        unsigned _sieveAfterMisses;
+        size_t _hits = 0;
+        size_t _misses = 0;
+
+        void evictToFit(size_t segments);
+    };
+}
+#endif
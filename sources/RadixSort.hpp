@@ -0,0 +1,111 @@
+#ifndef RADIXSORT_HPP
+#define RADIXSORT_HPP
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Parallel.hpp"
+
+namespace ariel
+{
+    // Batches at least this long are radix sorted by the container's bulk
+    // paths; below it std::sort wins (see `./bench radix`)
+    constexpr size_t RADIX_SORT_THRESHOLD = 1536;
+
+    constexpr unsigned RADIX_BITS = 11;
+    constexpr size_t RADIX_BUCKETS = size_t{1} << RADIX_BITS;
+
+    // Below this many elements per thread the histogram pass stays on one thread
+    constexpr size_t RADIX_MIN_CHUNK = 1 << 16;
+
+    // Unsigned key with the same order as value: signed values get their sign
+    // bit flipped, so negatives sort before non-negatives
+    template <typename T>
+    std::make_unsigned_t<T> radixKey(T value)
+    {
+        using Key = std::make_unsigned_t<T>;
+        auto key = static_cast<Key>(value);
+        if constexpr (std::is_signed_v<T>)
+        {
+            key = static_cast<Key>(key ^ static_cast<Key>(Key{1} << (sizeof(T) * 8 - 1)));
+        }
+        return key;
+    }
+
+    // Stable LSD radix sort with 11-bit digits: three passes for 32-bit
+    // keys, six for 64-bit. Each pass counts digits into one histogram per
+    // thread over contiguous chunks, turns the histograms into per-thread
+    // output offsets, and scatters every chunk in parallel. A pass whose
+    // digit is the same for every value is skipped. threads = 0 uses every
+    // hardware thread.
+    template <typename T>
+    void radixSort(std::span<T> values, unsigned threads = 1)
+    {
+        static_assert(std::is_integral_v<T>, "radixSort sorts integers");
+        size_t count = values.size();
+        if (count < 2)
+        {
+            return;
+        }
+
+        size_t chunks = std::max<size_t>(1, std::min<size_t>(resolveThreads(threads), count / RADIX_MIN_CHUNK));
+        std::vector<size_t> histograms(chunks * RADIX_BUCKETS);
+        std::vector<T> scratch(count);
+        std::span<T> from = values;
+        std::span<T> to(scratch);
+        auto digitOf = [](T value, unsigned shift)
+        {
+            return static_cast<size_t>(radixKey(value) >> shift) & (RADIX_BUCKETS - 1);
+        };
+
+        for (unsigned shift = 0; shift < sizeof(T) * 8; shift += RADIX_BITS)
+        {
+            std::fill(histograms.begin(), histograms.end(), 0);
+            parallelChunks(count, static_cast<unsigned>(chunks), [&](size_t first, size_t last, size_t chunk)
+                           {
+                               size_t *histogram = &histograms[chunk * RADIX_BUCKETS];
+                               for (size_t idx = first; idx < last; ++idx)
+                               {
+                                   ++histogram[digitOf(from[idx], shift)];
+                               } });
+
+            // Exclusive prefix sum in (digit, chunk) order keeps the sort stable
+            size_t offset = 0;
+            bool singleDigit = false;
+            for (size_t digit = 0; digit < RADIX_BUCKETS && !singleDigit; ++digit)
+            {
+                size_t digitTotal = 0;
+                for (size_t chunk = 0; chunk < chunks; ++chunk)
+                {
+                    size_t &slot = histograms[chunk * RADIX_BUCKETS + digit];
+                    size_t inChunk = slot;
+                    slot = offset;
+                    offset += inChunk;
+                    digitTotal += inChunk;
+                }
+                singleDigit = digitTotal == count;
+            }
+            if (singleDigit)
+            {
+                continue;
+            }
+
+            parallelChunks(count, static_cast<unsigned>(chunks), [&](size_t first, size_t last, size_t chunk)
+                           {
+                               size_t *next = &histograms[chunk * RADIX_BUCKETS];
+                               for (size_t idx = first; idx < last; ++idx)
+                               {
+                                   to[next[digitOf(from[idx], shift)]++] = from[idx];
+                               } });
+            std::swap(from, to);
+        }
+
+        if (from.data() != values.data())
+        {
+            std::copy(from.begin(), from.end(), values.begin());
+        }
+    }
+}
+#endif
@@ -0,0 +1,63 @@
+#include "SearchTree.hpp"
+#include "CpuFeatures.hpp"
+
+namespace ariel
+{
+    namespace
+    {
+        size_t slotScalar(const int *keys, size_t nodeCount, int value)
+        {
+            size_t slot = SIZE_MAX;
+            for (size_t node = 0; node < nodeCount;)
+            {
+                const int *nodeKeys = keys + node * SEARCH_TREE_KEYS;
+                size_t key = 0;
+                for (size_t idx = 0; idx < SEARCH_TREE_KEYS; ++idx)
+                {
+                    key += static_cast<size_t>(nodeKeys[idx] < value);
+                }
+                if (key < SEARCH_TREE_KEYS)
+                {
+                    slot = node * SEARCH_TREE_KEYS + key;
+                }
+                node = searchTreeChild(node, key);
+            }
+            return slot;
+        }
+
+#ifdef MAGICAL_HAVE_AVX2
+        // Counts the node's keys below value: two 8-lane compares, one mask
+        __attribute__((target("avx2,popcnt"))) size_t slotAvx2(const int *keys, size_t nodeCount, int value)
+        {
+            __m256i needle = _mm256_set1_epi32(value);
+            size_t slot = SIZE_MAX;
+            for (size_t node = 0; node < nodeCount;)
+            {
+                const int *nodeKeys = keys + node * SEARCH_TREE_KEYS;
+                __m256i low = _mm256_cmpgt_epi32(needle, _mm256_load_si256(reinterpret_cast<const __m256i *>(nodeKeys)));
+                __m256i high = _mm256_cmpgt_epi32(needle, _mm256_load_si256(reinterpret_cast<const __m256i *>(nodeKeys + 8)));
+                auto mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(low))) |
+                            (static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(high))) << 8U);
+                auto key = static_cast<size_t>(__builtin_popcount(mask));
+                if (key < SEARCH_TREE_KEYS)
+                {
+                    slot = node * SEARCH_TREE_KEYS + key;
+                }
+                node = searchTreeChild(node, key);
+            }
+            return slot;
+        }
+#endif
+    }
+
+    size_t searchTreeSlot(const int *keys, size_t nodeCount, int value)
+    {
+#ifdef MAGICAL_HAVE_AVX2
+        if (cpuHasAvx2())
+        {
+            return slotAvx2(keys, nodeCount, value);
+        }
+#endif
+        return slotScalar(keys, nodeCount, value);
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef SEARCHTREE_HPP
+#define SEARCHTREE_HPP
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace ariel
+{
+    // Keys per search tree node: 64 bytes of int keys, one cache line
+    constexpr size_t SEARCH_TREE_KEYS = 16;
+
+    // Child of node reached past its key-th key, in breadth-first order
+    constexpr size_t searchTreeChild(size_t node, size_t key) { return node * (SEARCH_TREE_KEYS + 1) + key + 1; }
+
+    // Lower-bound descent over int nodes of SEARCH_TREE_KEYS keys: returns
+    // the slot (node * SEARCH_TREE_KEYS + key) of the first key >= value, or
+    // SIZE_MAX when every key is smaller. Each node is ranked with two AVX2
+    // compares when the CPU has it and a scalar count otherwise.
+    size_t searchTreeSlot(const int *keys, size_t nodeCount, int value);
+
+    // Static search tree (S-tree) over a sorted array. Nodes hold
+    // SEARCH_TREE_KEYS keys and have SEARCH_TREE_KEYS + 1 children; node k's
+    // children are k * 17 + 1 .. k * 17 + 17, so the nodes sit in breadth
+    // first order and the top levels share a handful of cache lines. The
+    // keys are laid out in-order and padded with the largest T. A lookup
+    // costs one node, i.e. one cache line, per level: log17(n) misses
+    // instead of the log2(n) of a binary search.
+    template <typename T>
+    class SearchTree
+    {
+        struct alignas(64) Node
+        {
+            T keys[SEARCH_TREE_KEYS];
+        };
+
+        std::vector<Node> _nodes;
+        std::vector<uint32_t> _ranks; // Rank in the sorted array of every key slot
+        size_t _size = 0;
+
+        // In-order fill: the subtree left of each key, then the key itself
+        void fill(std::span<const T> sorted, size_t node, size_t &next)
+        {
+            if (node >= _nodes.size())
+            {
+                return;
+            }
+            for (size_t key = 0; key <= SEARCH_TREE_KEYS; ++key)
+            {
+                fill(sorted, searchTreeChild(node, key), next);
+                if (key < SEARCH_TREE_KEYS)
+                {
+                    bool real = next < sorted.size();
+                    _nodes[node].keys[key] = real ? sorted[next] : std::numeric_limits<T>::max();
+                    _ranks[node * SEARCH_TREE_KEYS + key] = static_cast<uint32_t>(real ? next++ : sorted.size());
+                }
+            }
+        }
+
+        // Slot of the first key >= value, SIZE_MAX when there is none
+        size_t slotOf(T value) const
+        {
+            if constexpr (std::is_same_v<T, int>)
+            {
+                return searchTreeSlot(reinterpret_cast<const int *>(_nodes.data()), _nodes.size(), value);
+            }
+            size_t slot = SIZE_MAX;
+            for (size_t node = 0; node < _nodes.size();)
+            {
+                size_t key = 0;
+                for (const T &candidate : _nodes[node].keys)
+                {
+                    key += static_cast<size_t>(candidate < value);
+                }
+                if (key < SEARCH_TREE_KEYS)
+                {
+                    slot = node * SEARCH_TREE_KEYS + key;
+                }
+                node = searchTreeChild(node, key);
+            }
+            return slot;
+        }
+
+        const T &keyAt(size_t slot) const { return _nodes[slot / SEARCH_TREE_KEYS].keys[slot % SEARCH_TREE_KEYS]; }
+
+    public:
+        // O(n): lays sorted out as a fresh tree
+        void build(std::span<const T> sorted)
+        {
+            _size = sorted.size();
+            _nodes.assign((_size + SEARCH_TREE_KEYS - 1) / SEARCH_TREE_KEYS, Node{});
+            _ranks.assign(_nodes.size() * SEARCH_TREE_KEYS, 0);
+            size_t next = 0;
+            fill(sorted, 0, next);
+        }
+
+        size_t size() const { return _size; }
+
+        // Rank of the first element >= value in the array the tree was built from
+        size_t lowerBound(T value) const
+        {
+            size_t slot = slotOf(value);
+            return slot == SIZE_MAX ? _size : _ranks[slot];
+        }
+
+        // Answered from the keys alone; only the largest T, which may be
+        // padding, needs the rank table
+        bool contains(T value) const
+        {
+            size_t slot = slotOf(value);
+            if (slot == SIZE_MAX || keyAt(slot) != value)
+            {
+                return false;
+            }
+            return value != std::numeric_limits<T>::max() || _ranks[slot] != _size;
+        }
+    };
+}
+#endif
@@ -0,0 +1,348 @@
+#ifndef SHARDEDMAGICALCONTAINER_HPP
+#define SHARDEDMAGICALCONTAINER_HPP
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <vector>
+#include "MagicalContainer.hpp"
+
+namespace ariel
+{
+    // Ascending or prime traversal across the shards of a sharded container:
+    // a (shard, offset) cursor that walks each shard's own Order and moves to
+    // the next non-empty shard at the end of one.
+    template <typename Sharded, typename Order>
+    class ShardedView : public std::ranges::view_interface<ShardedView<Sharded, Order>>
+    {
+    public:
+        class iterator
+        {
+            const Sharded *_owner = nullptr;
+            size_t _shard = 0;
+            size_t _offset = 0;
+            mutable typename Order::Cursor _cursor{}; // Storage cursor into the current shard
+
+            void skipExhausted()
+            {
+                while (_shard < _owner->shardCount() && _offset == Order::length(_owner->shard(_shard)))
+                {
+                    ++_shard;
+                    _offset = 0;
+                    _cursor = {};
+                }
+            }
+
+        public:
+            using iterator_concept = std::forward_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = typename Sharded::value_type;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            explicit iterator(const Sharded *owner) : _owner(owner) { skipExhausted(); }
+
+            value_type operator*() const { return Order::at(_owner->shard(_shard), _offset, _cursor); }
+
+            iterator &operator++()
+            {
+                ++_offset;
+                skipExhausted();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator before = *this;
+                ++*this;
+                return before;
+            }
+
+            bool operator==(const iterator &other) const { return _shard == other._shard && _offset == other._offset; }
+            bool operator==(std::default_sentinel_t) const { return _shard == _owner->shardCount(); }
+        };
+
+        ShardedView() = default;
+        explicit ShardedView(const Sharded &owner) : _owner(&owner) {}
+
+        iterator begin() const { return iterator(_owner); }
+        std::default_sentinel_t end() const { return std::default_sentinel; }
+
+    private:
+        const Sharded *_owner = nullptr;
+    };
+
+    // Side-cross traversal across shards: a front cursor walking up from the
+    // first shard and a back cursor walking down from the last, taken in turn
+    // until the two have produced every element.
+    template <typename Sharded>
+    class ShardedSideCrossView : public std::ranges::view_interface<ShardedSideCrossView<Sharded>>
+    {
+    public:
+        class iterator
+        {
+            const Sharded *_owner = nullptr;
+            size_t _frontShard = 0;
+            size_t _frontOffset = 0;
+            size_t _backShard = 0;
+            size_t _backOffset = 0;
+            size_t _remaining = 0;
+            bool _fromFront = true;
+            // Storage cursors into the front and back shards
+            mutable typename Sharded::shard_type::AscendingOrder::Cursor _frontCursor{};
+            mutable typename Sharded::shard_type::AscendingOrder::Cursor _backCursor{};
+
+            void settleFront()
+            {
+                while (_frontShard < _owner->shardCount() && _frontOffset == _owner->shard(_frontShard).size())
+                {
+                    ++_frontShard;
+                    _frontOffset = 0;
+                    _frontCursor = {};
+                }
+            }
+
+            // Puts the back cursor on element count - 1 of shard, or on the last
+            // element of the nearest earlier shard when count is 0
+            void settleBack(size_t shard, size_t count)
+            {
+                while (count == 0 && shard > 0)
+                {
+                    --shard;
+                    count = _owner->shard(shard).size();
+                }
+                if (shard != _backShard)
+                {
+                    _backCursor = {};
+                }
+                _backShard = shard;
+                _backOffset = count == 0 ? 0 : count - 1;
+            }
+
+        public:
+            using iterator_concept = std::forward_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = typename Sharded::value_type;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            explicit iterator(const Sharded *owner) : _owner(owner), _remaining(owner->size())
+            {
+                settleFront();
+                size_t last = _owner->shardCount() - 1;
+                settleBack(last, _owner->shard(last).size());
+            }
+
+            value_type operator*() const
+            {
+                using Ascending = typename Sharded::shard_type::AscendingOrder;
+                return _fromFront ? Ascending::at(_owner->shard(_frontShard), _frontOffset, _frontCursor)
+                                  : Ascending::at(_owner->shard(_backShard), _backOffset, _backCursor);
+            }
+
+            iterator &operator++()
+            {
+                if (_fromFront)
+                {
+                    ++_frontOffset;
+                    settleFront();
+                }
+                else
+                {
+                    settleBack(_backShard, _backOffset);
+                }
+                --_remaining;
+                _fromFront = !_fromFront;
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator before = *this;
+                ++*this;
+                return before;
+            }
+
+            bool operator==(const iterator &other) const { return _remaining == other._remaining; }
+            bool operator==(std::default_sentinel_t) const { return _remaining == 0; }
+        };
+
+        ShardedSideCrossView() = default;
+        explicit ShardedSideCrossView(const Sharded &owner) : _owner(&owner) {}
+
+        iterator begin() const { return iterator(_owner); }
+        std::default_sentinel_t end() const { return std::default_sentinel; }
+
+    private:
+        const Sharded *_owner = nullptr;
+    };
+
+    // Partitions the value space [low, high] into up to shardCount ranges of
+    // equal width, each a separate container with its own storage, prime
+    // index and reader-writer lock, so writers to different ranges do not
+    // contend. Values below low go to the first shard and values above high
+    // to the last. Bulk calls split their input by shard first.
+    //
+    // The views walk the shards in order. Like the plain container's views
+    // they do not lock, so iterate only while no writer is running.
+    template <typename T = int, typename Storage = VectorStorage, typename PrimePolicy = MillerRabinPrimality>
+    class BasicShardedMagicalContainer
+    {
+    public:
+        using value_type = T;
+        using shard_type = BasicMagicalContainer<T, Storage, PrimePolicy, SharedMutexLock>;
+
+    private:
+        vector<std::unique_ptr<shard_type>> _shards;
+        vector<T> _firsts; // Smallest value routed to each shard, ascending; _firsts[0] == low
+
+        // Splits batch into one run per shard
+        vector<vector<T>> partition(std::span<const T> batch) const
+        {
+            vector<vector<T>> parts(_shards.size());
+            for (T value : batch)
+            {
+                parts[shardIndexOf(value)].push_back(value);
+            }
+            return parts;
+        }
+
+        // Calls visit(shard, from, to) for each shard that [low, high] overlaps
+        template <typename Visit>
+        void forEachShardIn(T low, T high, Visit visit)
+        {
+            for (size_t idx = shardIndexOf(low); idx <= shardIndexOf(high); ++idx)
+            {
+                T from = idx == 0 ? low : std::max(low, _firsts[idx]);
+                T to = idx + 1 == _shards.size() ? high : std::min(high, static_cast<T>(_firsts[idx + 1] - 1));
+                visit(*_shards[idx], from, to);
+            }
+        }
+
+    public:
+        explicit BasicShardedMagicalContainer(size_t shardCount = 16, T low = std::numeric_limits<T>::min(), T high = std::numeric_limits<T>::max())
+        {
+            if (shardCount == 0 || low > high)
+            {
+                throw std::invalid_argument("ShardedMagicalContainer needs at least one shard and low <= high");
+            }
+            auto width = static_cast<uint64_t>(high) - static_cast<uint64_t>(low);
+            uint64_t step = width / shardCount + 1;
+            for (uint64_t offset = 0; _firsts.size() < shardCount && offset <= width; offset += step)
+            {
+                _firsts.push_back(static_cast<T>(static_cast<uint64_t>(low) + offset));
+                _shards.push_back(std::make_unique<shard_type>());
+            }
+        }
+
+        // Disable copy constructor
+        BasicShardedMagicalContainer(const BasicShardedMagicalContainer &) = delete;
+
+        // Disable copy assignment operator
+        BasicShardedMagicalContainer &operator=(const BasicShardedMagicalContainer &) = delete;
+        ~BasicShardedMagicalContainer() = default;
+
+        size_t shardCount() const { return _shards.size(); }
+        const shard_type &shard(size_t idx) const { return *_shards[idx]; }
+        shard_type &shard(size_t idx) { return *_shards[idx]; }
+
+        size_t shardIndexOf(T value) const
+        {
+            return static_cast<size_t>(std::upper_bound(_firsts.begin() + 1, _firsts.end(), value) - (_firsts.begin() + 1));
+        }
+
+        void addElement(T element) { _shards[shardIndexOf(element)]->addElement(element); }
+
+        void addElements(std::span<const T> elements)
+        {
+            vector<vector<T>> parts = partition(elements);
+            for (size_t idx = 0; idx < parts.size(); ++idx)
+            {
+                if (!parts[idx].empty())
+                {
+                    _shards[idx]->addElements(std::span<const T>(parts[idx]));
+                }
+            }
+        }
+
+        void addRange(T low, T high)
+        {
+            if (low <= high)
+            {
+                forEachShardIn(low, high, [](shard_type &shard, T from, T to)
+                               { shard.addRange(from, to); });
+            }
+        }
+
+        void removeElement(T element) { _shards[shardIndexOf(element)]->removeElement(element); }
+        bool tryRemove(T element) { return _shards[shardIndexOf(element)]->tryRemove(element); }
+        bool contains(T element) const { return _shards[shardIndexOf(element)]->contains(element); }
+
+        size_t removeElements(std::span<const T> elements)
+        {
+            vector<vector<T>> parts = partition(elements);
+            size_t removed = 0;
+            for (size_t idx = 0; idx < parts.size(); ++idx)
+            {
+                if (!parts[idx].empty())
+                {
+                    removed += _shards[idx]->removeElements(std::span<const T>(parts[idx]));
+                }
+            }
+            return removed;
+        }
+
+        size_t removeRange(T low, T high)
+        {
+            size_t removed = 0;
+            if (low <= high)
+            {
+                forEachShardIn(low, high, [&removed](shard_type &shard, T from, T to)
+                               { removed += shard.removeRange(from, to); });
+            }
+            return removed;
+        }
+
+        template <typename Predicate>
+        size_t removeIf(Predicate pred)
+        {
+            size_t removed = 0;
+            for (auto &shard : _shards)
+            {
+                removed += shard->removeIf(pred);
+            }
+            return removed;
+        }
+
+        // Sum of the shard sizes; each shard is read under its own lock
+        size_t size() const
+        {
+            size_t total = 0;
+            for (const auto &shard : _shards)
+            {
+                total += shard->size();
+            }
+            return total;
+        }
+
+        using AscendingView = ShardedView<BasicShardedMagicalContainer, typename shard_type::AscendingOrder>;
+        using PrimeView = ShardedView<BasicShardedMagicalContainer, typename shard_type::PrimeOrder>;
+        using SideCrossView = ShardedSideCrossView<BasicShardedMagicalContainer>;
+
+        AscendingView ascending() const { return AscendingView(*this); }
+        PrimeView primes() const { return PrimeView(*this); }
+        SideCrossView sideCross() const { return SideCrossView(*this); }
+    };
+
+    using ShardedMagicalContainer = BasicShardedMagicalContainer<>;
+}
+
+template <typename Sharded, typename Order>
+inline constexpr bool std::ranges::enable_borrowed_range<ariel::ShardedView<Sharded, Order>> = true;
+
+template <typename Sharded>
+inline constexpr bool std::ranges::enable_borrowed_range<ariel::ShardedSideCrossView<Sharded>> = true;
+#endif
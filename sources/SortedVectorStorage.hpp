@@ -0,0 +1,190 @@
+#ifndef SORTEDVECTORSTORAGE_HPP
+#define SORTEDVECTORSTORAGE_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ariel
+{
+    // Sorted set of unique values in one flat std::vector. This is the
+    // container's default storage; inserts and erases shift the tail, while
+    // lookups and ascending scans run over contiguous memory.
+    //
+    // Each value also carries a prime tag. The tags are kept as the ranks of
+    // the tagged values in ascending order, so the k-th prime is one index
+    // away; an insert or erase shifts the later ranks along with the tail.
+    template <typename T>
+    class SortedVectorStorage
+    {
+        std::vector<T> _values;
+        std::vector<uint32_t> _prime; // Ranks of the tagged values, ascending
+
+        // First entry of _prime at or after rank
+        std::vector<uint32_t>::iterator primeFrom(size_t rank)
+        {
+            return std::lower_bound(_prime.begin(), _prime.end(), static_cast<uint32_t>(rank));
+        }
+
+    public:
+        using value_type = T;
+        using const_iterator = typename std::vector<T>::const_iterator;
+
+        // Every rank is one index away, so there is nothing to remember
+        struct Cursor
+        {
+        };
+
+        size_t size() const { return _values.size(); }
+        bool empty() const { return _values.empty(); }
+
+        const_iterator begin() const { return _values.begin(); }
+        const_iterator end() const { return _values.end(); }
+
+        const T &operator[](size_t rank) const { return _values[rank]; }
+        const T &at(size_t rank, Cursor &) const { return _values[rank]; }
+
+        // The underlying vector, for callers that want contiguous reads;
+        // writes go through the members below so the prime ranks stay valid
+        const std::vector<T> &raw() const { return _values; }
+
+        size_t lowerBound(const T &value) const
+        {
+            return static_cast<size_t>(std::lower_bound(_values.begin(), _values.end(), value) - _values.begin());
+        }
+
+        size_t upperBound(const T &value) const
+        {
+            return static_cast<size_t>(std::upper_bound(_values.begin(), _values.end(), value) - _values.begin());
+        }
+
+        bool contains(const T &value) const
+        {
+            return std::binary_search(_values.begin(), _values.end(), value);
+        }
+
+        // Number of prime-tagged values
+        size_t primeCount() const { return _prime.size(); }
+
+        // Rank of the k-th prime-tagged value, and the value itself
+        size_t primeRank(size_t k) const { return _prime[k]; }
+        const T &primeAt(size_t k) const { return _values[_prime[k]]; }
+        const T &primeAt(size_t k, Cursor &) const { return _values[_prime[k]]; }
+
+        // Prime-tagged values ranked below rank
+        size_t primesBefore(size_t rank) const
+        {
+            return static_cast<size_t>(std::lower_bound(_prime.begin(), _prime.end(), rank) - _prime.begin());
+        }
+
+        // Calls fn(value, prime) for every value in ascending order
+        template <typename Fn>
+        void forEachTagged(Fn fn) const
+        {
+            auto primeIt = _prime.begin();
+            for (size_t rank = 0; rank < _values.size(); ++rank)
+            {
+                bool prime = primeIt != _prime.end() && *primeIt == rank;
+                primeIt += prime;
+                fn(_values[rank], prime);
+            }
+        }
+
+        // rank must be lowerBound(value) and value must not be present
+        void insertAt(size_t rank, const T &value, bool prime = false)
+        {
+            _values.insert(_values.begin() + static_cast<std::ptrdiff_t>(rank), value);
+
+            // Every prime at or after the insertion point moves one slot to the right
+            auto primeIt = primeFrom(rank);
+            for (auto shiftIt = primeIt; shiftIt != _prime.end(); ++shiftIt)
+            {
+                ++(*shiftIt);
+            }
+            if (prime)
+            {
+                _prime.insert(primeIt, static_cast<uint32_t>(rank));
+            }
+        }
+
+        void eraseAt(size_t rank)
+        {
+            _values.erase(_values.begin() + static_cast<std::ptrdiff_t>(rank));
+
+            // Drop the tag of the erased value and shift the later ones back
+            auto primeIt = primeFrom(rank);
+            if (primeIt != _prime.end() && *primeIt == rank)
+            {
+                primeIt = _prime.erase(primeIt);
+            }
+            for (; primeIt != _prime.end(); ++primeIt)
+            {
+                --(*primeIt);
+            }
+        }
+
+        void eraseRange(size_t first, size_t last)
+        {
+            _values.erase(_values.begin() + static_cast<std::ptrdiff_t>(first), _values.begin() + static_cast<std::ptrdiff_t>(last));
+
+            auto primeFirst = primeFrom(first);
+            auto primeLast = std::lower_bound(primeFirst, _prime.end(), static_cast<uint32_t>(last));
+            for (auto primeTail = _prime.erase(primeFirst, primeLast); primeTail != _prime.end(); ++primeTail)
+            {
+                *primeTail -= static_cast<uint32_t>(last - first);
+            }
+        }
+
+        // Keeps, from rank first on, the values for which keep(rank, value)
+        // holds, in one in-place pass over the values and the tags; each kept
+        // tag moves back by the number of values dropped before it. Returns
+        // how many values were dropped.
+        template <typename Keep>
+        size_t retainFrom(size_t first, Keep keep)
+        {
+            auto primeIt = primeFrom(first);
+            auto keptPrime = primeIt;
+            size_t kept = first;
+            for (size_t rank = first; rank < _values.size(); ++rank)
+            {
+                bool prime = primeIt != _prime.end() && *primeIt == rank;
+                primeIt += prime;
+                if (keep(rank, _values[rank]))
+                {
+                    if (prime)
+                    {
+                        *keptPrime++ = static_cast<uint32_t>(kept);
+                    }
+                    _values[kept++] = _values[rank];
+                }
+            }
+            _prime.erase(keptPrime, _prime.end());
+            size_t dropped = _values.size() - kept;
+            _values.resize(kept);
+            return dropped;
+        }
+
+        // Replaces the contents with a sorted, duplicate-free sequence;
+        // primeFlags[i] != 0 tags sorted[i], and no flags means no primes
+        void assign(std::vector<T> &&sorted, std::span<const uint8_t> primeFlags = {})
+        {
+            _values = std::move(sorted);
+            _prime.clear();
+            for (size_t rank = 0; rank < primeFlags.size(); ++rank)
+            {
+                if (primeFlags[rank] != 0)
+                {
+                    _prime.push_back(static_cast<uint32_t>(rank));
+                }
+            }
+        }
+
+        void clear()
+        {
+            _values.clear();
+            _prime.clear();
+        }
+    };
+}
+#endif
@@ -0,0 +1,189 @@
+#include "SortingNetwork.hpp"
+#include "CpuFeatures.hpp"
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <stdexcept>
+
+namespace ariel
+{
+    namespace
+    {
+        constexpr size_t LANES = 8;
+
+        // Copies values into buffer and pads it with INT_MAX to a power of two
+        // of at least LANES; returns the padded length
+        size_t padInto(std::span<const int> values, int *buffer)
+        {
+            if (values.size() > SORTING_NETWORK_MAX)
+            {
+                throw std::runtime_error("sortSmall handles at most SORTING_NETWORK_MAX values");
+            }
+            size_t padded = std::max(LANES, std::bit_ceil(values.size()));
+            std::copy(values.begin(), values.end(), buffer);
+            std::fill(buffer + values.size(), buffer + padded, INT_MAX);
+            return padded;
+        }
+
+        void compareExchange(int &low, int &high)
+        {
+            int smaller = std::min(low, high);
+            high = std::max(low, high);
+            low = smaller;
+        }
+
+        // Bitonic sort with a flip stage: for each run length, element i of a
+        // block meets its mirror 2 * run - 1 - i, then half-cleaners with
+        // halving strides finish the merge
+        void sortScalar(int *buffer, size_t padded)
+        {
+            for (size_t run = 1; run < padded; run *= 2)
+            {
+                for (size_t block = 0; block < padded; block += 2 * run)
+                {
+                    for (size_t i = 0; i < run; ++i)
+                    {
+                        compareExchange(buffer[block + i], buffer[block + 2 * run - 1 - i]);
+                    }
+                }
+                for (size_t stride = run / 2; stride > 0; stride /= 2)
+                {
+                    for (size_t block = 0; block < padded; block += 2 * stride)
+                    {
+                        for (size_t i = 0; i < stride; ++i)
+                        {
+                            compareExchange(buffer[block + i], buffer[block + i + stride]);
+                        }
+                    }
+                }
+            }
+        }
+
+#ifdef MAGICAL_HAVE_AVX2
+        // Compare-exchange of value with a lane permutation of itself: lanes
+        // set in HighLanes keep the larger value, the others the smaller
+        template <int HighLanes>
+        __attribute__((target("avx2"))) __m256i exchange(__m256i value, __m256i partner)
+        {
+            return _mm256_blend_epi32(_mm256_min_epi32(value, partner), _mm256_max_epi32(value, partner), HighLanes);
+        }
+
+        __attribute__((target("avx2"))) __m256i reverseLanes(__m256i value)
+        {
+            return _mm256_permutevar8x32_epi32(value, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        }
+
+        __attribute__((target("avx2"))) __m256i swapPairs(__m256i value)
+        {
+            return _mm256_shuffle_epi32(value, _MM_SHUFFLE(2, 3, 0, 1));
+        }
+
+        // Half-cleaners with strides 4, 2 and 1 inside one register
+        __attribute__((target("avx2"))) __m256i cleanLanes(__m256i value)
+        {
+            value = exchange<0xF0>(value, _mm256_permute2x128_si256(value, value, 1));
+            value = exchange<0xCC>(value, _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));
+            return exchange<0xAA>(value, swapPairs(value));
+        }
+
+        // The whole 8-lane bitonic network on one register
+        __attribute__((target("avx2"))) __m256i sortLanes(__m256i value)
+        {
+            value = exchange<0xAA>(value, swapPairs(value));
+            value = exchange<0xCC>(value, _mm256_shuffle_epi32(value, _MM_SHUFFLE(0, 1, 2, 3)));
+            value = exchange<0xAA>(value, swapPairs(value));
+            value = exchange<0xF0>(value, reverseLanes(value));
+            value = exchange<0xCC>(value, _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));
+            return exchange<0xAA>(value, swapPairs(value));
+        }
+
+        // Merge kernel: turns sorted runs of run registers into sorted runs of
+        // 2 * run. The flip stage pairs lane l of a register with lane 7 - l
+        // of its mirror, the cross-register half-cleaners are plain min/max,
+        // and the last three strides happen inside each register.
+        __attribute__((target("avx2"))) void mergeRuns(__m256i *regs, size_t count, size_t run)
+        {
+            for (size_t block = 0; block < count; block += 2 * run)
+            {
+                for (size_t i = 0; i < run; ++i)
+                {
+                    __m256i &low = regs[block + i];
+                    __m256i &high = regs[block + 2 * run - 1 - i];
+                    __m256i mirrored = reverseLanes(high);
+                    high = reverseLanes(_mm256_max_epi32(low, mirrored));
+                    low = _mm256_min_epi32(low, mirrored);
+                }
+            }
+            for (size_t stride = run / 2; stride > 0; stride /= 2)
+            {
+                for (size_t block = 0; block < count; block += 2 * stride)
+                {
+                    for (size_t i = 0; i < stride; ++i)
+                    {
+                        __m256i low = regs[block + i];
+                        regs[block + i] = _mm256_min_epi32(low, regs[block + i + stride]);
+                        regs[block + i + stride] = _mm256_max_epi32(low, regs[block + i + stride]);
+                    }
+                }
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                regs[i] = cleanLanes(regs[i]);
+            }
+        }
+
+        __attribute__((target("avx2"))) void sortAvx2(int *buffer, size_t padded)
+        {
+            __m256i regs[SORTING_NETWORK_MAX / LANES];
+            size_t count = padded / LANES;
+            for (size_t i = 0; i < count; ++i)
+            {
+                regs[i] = sortLanes(_mm256_load_si256(reinterpret_cast<const __m256i *>(buffer + i * LANES)));
+            }
+            for (size_t run = 1; run < count; run *= 2)
+            {
+                mergeRuns(regs, count, run);
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                _mm256_store_si256(reinterpret_cast<__m256i *>(buffer + i * LANES), regs[i]);
+            }
+        }
+#endif
+    }
+
+    void sortSmall(std::span<int> values)
+    {
+        if (values.size() < 2)
+        {
+            return;
+        }
+#ifdef MAGICAL_HAVE_AVX2
+        if (cpuHasAvx2())
+        {
+            alignas(32) int buffer[SORTING_NETWORK_MAX];
+            size_t padded = padInto(values, buffer);
+            sortAvx2(buffer, padded);
+            std::copy(buffer, buffer + values.size(), values.begin());
+            return;
+        }
+#endif
+        if (values.size() > SORTING_NETWORK_MAX)
+        {
+            throw std::runtime_error("sortSmall handles at most SORTING_NETWORK_MAX values");
+        }
+        std::sort(values.begin(), values.end());
+    }
+
+    void sortSmallScalar(std::span<int> values)
+    {
+        if (values.size() < 2)
+        {
+            return;
+        }
+        int buffer[SORTING_NETWORK_MAX];
+        size_t padded = padInto(values, buffer);
+        sortScalar(buffer, padded);
+        std::copy(buffer, buffer + values.size(), values.begin());
+    }
+}
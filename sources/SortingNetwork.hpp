@@ -0,0 +1,29 @@
+#ifndef SORTINGNETWORK_HPP
+#define SORTINGNETWORK_HPP
+#include <cstddef>
+#include <span>
+
+namespace ariel
+{
+    // Longest batch the sorting network handles
+    constexpr size_t SORTING_NETWORK_MAX = 256;
+
+    // Batches at least this long (and at most SORTING_NETWORK_MAX) go through
+    // the network in the container's bulk paths; shorter ones would be mostly
+    // padding and are left to std::sort (see `./bench network`)
+    constexpr size_t SORTING_NETWORK_MIN = 8;
+
+    // Sorts a micro-batch of up to SORTING_NETWORK_MAX values with a bitonic
+    // network. The batch is padded with INT_MAX to a power of two of at least
+    // eight, each group of eight is sorted inside one AVX2 register, and the
+    // sorted runs are then merged pairwise by a bitonic merge kernel that
+    // works a whole register at a time. Without AVX2 it falls back to
+    // std::sort, which beats the scalar network at every batch size.
+    // Throws std::runtime_error for longer batches.
+    void sortSmall(std::span<int> values);
+
+    // The same network on scalar compare-exchanges, whatever the CPU
+    // supports; the portable reference for the AVX2 kernel
+    void sortSmallScalar(std::span<int> values);
+}
+#endif